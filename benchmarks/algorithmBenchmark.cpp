@@ -0,0 +1,80 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#include "../src/parallel.h"
+#include "benchmark.h"
+#include <cstdlib>
+#include <random>
+
+namespace {
+// fewer repeats for large sizes, the best time is taken
+template<typename Prepare, typename F>
+auto best_of(size_t size, Prepare&& prepare, F&& f) -> double
+{
+    auto repeats = std::clamp(size_t{ 10000000 } / size, size_t{ 1 }, size_t{ 5 });
+    auto best = std::chrono::nanoseconds::max();
+
+    for (auto r = size_t{ 0 }; r < repeats; r++) {
+        prepare();
+        best = std::min(best, bench::measure(f));
+    }
+
+    return std::chrono::duration<double, std::milli>{ best }.count();
+}
+}
+
+// taskweaver scans and sort against the sequential std algorithms,
+// the largest size can be given as the first argument (1e8 by default)
+int main(int argc, char** argv)
+{
+    auto maxSize = argc > 1 ? static_cast<size_t>(std::strtoull(argv[1], nullptr, 10)) : size_t{ 100000000 };
+
+    auto taskManager = taskweaver::TaskManager{};
+    taskManager.Start();
+
+    std::printf("%u executors, times in ms\n", taskManager.ExecutorCount());
+    std::printf("%10s %12s %12s %12s %12s %12s %12s\n",
+                "size",
+                "incl std",
+                "incl tw",
+                "excl std",
+                "excl tw",
+                "sort std",
+                "sort tw");
+
+    auto random = std::mt19937{ 42 };
+
+    for (auto size = size_t{ 1000 }; size <= maxSize; size *= 10) {
+        auto source = std::vector<uint32_t>(size);
+        for (auto& v : source) {
+            v = static_cast<uint32_t>(random());
+        }
+
+        auto values = std::vector<uint32_t>(size);
+        auto nothing = []() -> void {};
+        auto reset = [&values, &source]() -> void { std::copy(source.begin(), source.end(), values.begin()); };
+
+        auto inclStd = best_of(
+          size, nothing, [&]() -> void { std::inclusive_scan(source.begin(), source.end(), values.begin()); });
+        auto inclTw = best_of(
+          size, nothing, [&]() -> void { taskweaver::inclusive_scan(source.begin(), source.end(), values.begin()); });
+
+        auto exclStd = best_of(size, nothing, [&]() -> void {
+            std::exclusive_scan(source.begin(), source.end(), values.begin(), uint32_t{ 0 });
+        });
+        auto exclTw = best_of(size, nothing, [&]() -> void {
+            taskweaver::exclusive_scan(source.begin(), source.end(), values.begin(), uint32_t{ 0 });
+        });
+
+        auto sortStd = best_of(size, reset, [&]() -> void { std::sort(values.begin(), values.end()); });
+        auto sortTw = best_of(size, reset, [&]() -> void { taskweaver::sort(values.begin(), values.end()); });
+
+        std::printf(
+          "%10zu %12.3f %12.3f %12.3f %12.3f %12.3f %12.3f\n", size, inclStd, inclTw, exclStd, exclTw, sortStd, sortTw);
+    }
+
+    taskManager.Stop();
+
+    return 0;
+}
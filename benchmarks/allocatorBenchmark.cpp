@@ -0,0 +1,178 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#include "../src/taskManager.h"
+#include "benchmark.h"
+#include <cstdlib>
+#include <memory_resource>
+
+namespace {
+constexpr auto batch = size_t{ 1024 };
+constexpr auto rounds = size_t{ 2000 };
+constexpr auto sizes = std::array<size_t, 4>{ 48, 112, 240, 496 };
+
+struct malloc_t
+{
+    static auto allocate(size_t size) -> void* { return std::malloc(size); }
+
+    static void deallocate(void* p) { std::free(p); }
+};
+
+struct slab_t
+{
+    static auto allocate(size_t size) -> void* { return taskweaver::SlabAllocator::ThreadAllocate(size); }
+
+    static void deallocate(void* p) { taskweaver::SlabAllocator::Deallocate(p); }
+};
+
+// a batch of blocks is allocated and released by the same thread
+template<typename Allocator>
+auto local(size_t size) -> double
+{
+    auto blocks = std::vector<void*>(batch);
+
+    auto elapsed = bench::measure([&blocks, size]() -> void {
+        for (auto r = size_t{ 0 }; r < rounds; r++) {
+            for (auto& block : blocks) {
+                block = Allocator::allocate(size);
+                static_cast<std::byte*>(block)[0] = std::byte{ 1 };
+            }
+
+            for (auto* block : blocks) {
+                Allocator::deallocate(block);
+            }
+        }
+    });
+
+    return static_cast<double>(elapsed.count()) / static_cast<double>(batch * rounds);
+}
+
+// blocks are allocated by one thread and released by another one, like captures of stolen tasks
+template<typename Allocator>
+auto remote(size_t size) -> double
+{
+    auto slab = taskweaver::SlabAllocator{};
+    auto blocks = std::vector<void*>(batch);
+    auto ready = std::atomic<size_t>{ 0 };
+    auto released = std::atomic<size_t>{ 0 };
+
+    auto consumer = std::thread{ [&blocks, &ready, &released]() -> void {
+        for (auto r = size_t{ 1 }; r <= rounds; r++) {
+            while (ready.load(std::memory_order_acquire) != r)
+                std::this_thread::yield();
+
+            for (auto* block : blocks) {
+                Allocator::deallocate(block);
+            }
+
+            released.store(r, std::memory_order_release);
+        }
+    } };
+
+    taskweaver::SlabAllocator::SetThreadAllocator(&slab);
+
+    auto elapsed = bench::measure([&blocks, &ready, &released, size]() -> void {
+        for (auto r = size_t{ 1 }; r <= rounds; r++) {
+            for (auto& block : blocks) {
+                block = Allocator::allocate(size);
+                static_cast<std::byte*>(block)[0] = std::byte{ 1 };
+            }
+
+            ready.store(r, std::memory_order_release);
+
+            while (released.load(std::memory_order_acquire) != r)
+                std::this_thread::yield();
+        }
+    });
+
+    consumer.join();
+    taskweaver::SlabAllocator::SetThreadAllocator(nullptr);
+
+    return static_cast<double>(elapsed.count()) / static_cast<double>(batch * rounds);
+}
+
+// a small pmr vector grown from scratch, like the continuation nodes of when_all
+auto containers(std::pmr::memory_resource* resource) -> double
+{
+    auto elapsed = bench::measure([resource]() -> void {
+        for (auto r = size_t{ 0 }; r < rounds * 16; r++) {
+            auto v = std::pmr::vector<uint64_t>(resource);
+            for (auto i = uint64_t{ 0 }; i < 48; i++) {
+                v.push_back(i);
+            }
+        }
+    });
+
+    return static_cast<double>(elapsed.count()) / static_cast<double>(rounds * 16);
+}
+
+// tasks with captures which do not fit the task slot, boxed in the slab or held by a heap block
+auto tasks(bool slab) -> double
+{
+    constexpr auto count = size_t{ 1 } << 18;
+
+    auto taskManager = taskweaver::TaskManager{};
+    taskManager.Start();
+
+    auto sum = std::atomic<uint64_t>{ 0 };
+    auto payload = std::array<uint64_t, 24>{};
+    payload.fill(1);
+
+    auto elapsed = bench::measure([&sum, &payload, slab]() -> void {
+        auto& executor = taskweaver::Executor::ThreadExecutor();
+
+        for (auto i = size_t{ 0 }; i < count; i++) {
+            if (slab) {
+                executor.Dispatch([&sum, payload]() -> void { sum.fetch_add(payload[0], std::memory_order_relaxed); });
+            } else {
+                auto boxed = std::make_unique<std::array<uint64_t, 24>>(payload);
+                executor.Dispatch([&sum, boxed = std::move(boxed)]() -> void {
+                    sum.fetch_add((*boxed)[0], std::memory_order_relaxed);
+                });
+            }
+        }
+
+        while (sum.load(std::memory_order_acquire) != count)
+            executor.TryRunOne();
+    });
+
+    taskManager.Stop();
+
+    return static_cast<double>(elapsed.count()) / static_cast<double>(count);
+}
+}
+
+int main()
+{
+    auto setup = taskweaver::SlabAllocator{};
+    taskweaver::SlabAllocator::SetThreadAllocator(&setup);
+
+    for (auto size : sizes) {
+        std::printf("%3zu bytes, local: malloc %.1f ns, slab %.1f ns\n",
+                    size,
+                    local<malloc_t>(size),
+                    local<slab_t>(size));
+    }
+
+    taskweaver::SlabAllocator::SetThreadAllocator(nullptr);
+
+    for (auto size : sizes) {
+        std::printf("%3zu bytes, remote free: malloc %.1f ns, slab %.1f ns\n",
+                    size,
+                    remote<malloc_t>(size),
+                    remote<slab_t>(size));
+    }
+
+    taskweaver::SlabAllocator::SetThreadAllocator(&setup);
+
+    std::printf("pmr vector of 48: new_delete_resource %.1f ns, slab %.1f ns\n",
+                containers(std::pmr::new_delete_resource()),
+                containers(taskweaver::SlabAllocator::ThreadResource()));
+
+    taskweaver::SlabAllocator::SetThreadAllocator(nullptr);
+
+    std::printf("192 byte captures: heap boxed %.1f ns, slab boxed %.1f ns per task\n", tasks(false), tasks(true));
+
+    return 0;
+}
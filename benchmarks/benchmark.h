@@ -0,0 +1,49 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#ifndef TASKWEAVER_BENCHMARK_H
+#define TASKWEAVER_BENCHMARK_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <vector>
+
+namespace bench {
+using clock_t = std::chrono::steady_clock;
+
+struct percentiles_t
+{
+    double median;
+    double p99;
+    double max;
+};
+
+template<typename F>
+auto measure(F&& f) -> std::chrono::nanoseconds
+{
+    auto start = clock_t::now();
+    f();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_t::now() - start);
+}
+
+// cpu time consumed by all threads of the process
+inline auto cpu_time() -> std::chrono::duration<double>
+{
+    return std::chrono::duration<double>{ static_cast<double>(std::clock()) / CLOCKS_PER_SEC };
+}
+
+inline auto percentiles(std::vector<double> samples) -> percentiles_t
+{
+    if (samples.empty())
+        return percentiles_t{ 0.0, 0.0, 0.0 };
+
+    std::sort(samples.begin(), samples.end());
+
+    return percentiles_t{ samples[samples.size() / 2], samples[(samples.size() * 99) / 100], samples.back() };
+}
+}
+
+#endif // TASKWEAVER_BENCHMARK_H
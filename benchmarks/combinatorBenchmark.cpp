@@ -0,0 +1,78 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#include "../src/utility.h"
+#include "benchmark.h"
+
+namespace {
+auto work(uint32_t i) -> uint32_t
+{
+    auto x = i;
+
+    for (auto k = 0; k < 64; k++) {
+        x = x * 1664525u + 1013904223u;
+    }
+
+    return x;
+}
+
+// when_all of three tasks and when_any of two tasks, joined by another when_all
+auto graph(uint32_t i)
+{
+    auto all = taskweaver::when_all(taskweaver::TaskManager::SubmitTask([i]() -> uint32_t { return work(i); }),
+                                    taskweaver::TaskManager::SubmitTask([i]() -> uint32_t { return work(i + 1); }),
+                                    taskweaver::TaskManager::SubmitTask([i]() -> uint32_t { return work(i + 2); }));
+
+    auto any = taskweaver::when_any(taskweaver::TaskManager::SubmitTask([i]() -> uint32_t { return work(i + 3); }),
+                                    taskweaver::TaskManager::SubmitTask([i]() -> uint32_t { return work(i + 4); }));
+
+    return taskweaver::when_all(std::move(all), std::move(any));
+}
+}
+
+// throughput and cpu usage of many concurrent when_all/when_any graphs,
+// no worker is blocked or polls while the inputs are pending
+int main()
+{
+    constexpr auto graphCount = uint32_t{ 10000 };
+    constexpr auto rounds = size_t{ 10 };
+
+    auto taskManager = taskweaver::TaskManager{};
+    taskManager.Start();
+
+    auto checksum = uint32_t{ 0 };
+    auto cpuStart = bench::cpu_time();
+
+    auto elapsed = bench::measure([&checksum]() -> void {
+        for (auto r = size_t{ 0 }; r < rounds; r++) {
+            auto graphs = std::vector<decltype(graph(0))>{};
+            graphs.reserve(graphCount);
+
+            for (auto i = uint32_t{ 0 }; i < graphCount; i++) {
+                graphs.push_back(graph(i));
+            }
+
+            for (auto& [all, any] : taskweaver::when_all(graphs).get()) {
+                checksum ^= std::get<0>(all) ^ std::get<1>(all) ^ std::get<2>(all) ^ static_cast<uint32_t>(any.index);
+            }
+        }
+    });
+
+    auto cpu = bench::cpu_time() - cpuStart;
+    auto graphs = static_cast<double>(graphCount * rounds);
+
+    std::printf("%u concurrent graphs x %zu rounds in %.3f ms, %.0f graphs per second (%u executors)\n",
+                graphCount,
+                rounds,
+                std::chrono::duration<double, std::milli>{ elapsed }.count(),
+                graphs / std::chrono::duration<double>{ elapsed }.count(),
+                taskManager.ExecutorCount());
+
+    std::printf("cpu time: %.3f ms, %.2f us per graph\n", cpu.count() * 1000.0, cpu.count() * 1e6 / graphs);
+    std::printf("checksum: %u\n", checksum);
+
+    taskManager.Stop();
+
+    return 0;
+}
@@ -0,0 +1,54 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#include "../src/taskManager.h"
+#include "benchmark.h"
+
+namespace {
+constexpr auto batch = size_t{ 256 };
+constexpr auto rounds = size_t{ 4000 };
+
+// submits a batch of tiny tasks and runs them in the main thread
+template<typename Submit>
+auto run(Submit&& submit) -> double
+{
+    auto& executor = taskweaver::Executor::ThreadExecutor();
+
+    auto elapsed = bench::measure([&]() -> void {
+        for (auto r = size_t{ 0 }; r < rounds; r++) {
+            for (auto i = size_t{ 0 }; i < batch; i++) {
+                submit(i);
+            }
+
+            for (auto i = size_t{ 0 }; i < batch; i++) {
+                executor.RunOne();
+            }
+        }
+    });
+
+    return static_cast<double>(elapsed.count()) / static_cast<double>(batch * rounds);
+}
+}
+
+// per task overhead of fire and forget tasks compared to tasks with discarded futures
+int main()
+{
+    // no worker threads, tasks are executed by the main thread
+    auto taskManager = taskweaver::TaskManager{ 256, 0 };
+    auto& executor = taskweaver::Executor::ThreadExecutor();
+
+    auto sum = uint64_t{ 0 };
+
+    auto submit = run([&executor, &sum](size_t i) -> void {
+        [[maybe_unused]] auto future = executor.SubmitTask([&sum, i]() -> void { sum += i; });
+    });
+
+    auto dispatch = run([&executor, &sum](size_t i) -> void { executor.Dispatch([&sum, i]() -> void { sum += i; }); });
+
+    std::printf("SubmitTask: %.1f ns per task\n", submit);
+    std::printf("Dispatch:   %.1f ns per task\n", dispatch);
+    std::printf("checksum: %llu\n", static_cast<unsigned long long>(sum));
+
+    return 0;
+}
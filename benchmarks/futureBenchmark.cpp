@@ -0,0 +1,109 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#include "../src/taskManager.h"
+#include "benchmark.h"
+#include <cstdlib>
+
+namespace {
+std::atomic<size_t> _allocations{ 0 };
+}
+
+// counts every allocation made by the process
+auto operator new(size_t size) -> void*
+{
+    _allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (auto* ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace {
+struct result_t
+{
+    double nsPerTask;
+    double allocationsPerTask;
+};
+
+// submits a batch of tiny tasks, runs them in the main thread and collects results
+template<typename Submit>
+auto run(Submit&& submit) -> result_t
+{
+    constexpr auto batch = size_t{ 256 };
+    constexpr auto rounds = size_t{ 2000 };
+
+    auto& executor = taskweaver::Executor::ThreadExecutor();
+
+    auto allocations = _allocations.load();
+    auto sum = uint64_t{ 0 };
+
+    auto elapsed = bench::measure([&]() -> void {
+        for (auto r = size_t{ 0 }; r < rounds; r++) {
+            auto futures = std::array<decltype(submit(size_t{ 0 })), batch>{};
+
+            for (auto i = size_t{ 0 }; i < batch; i++) {
+                futures[i] = submit(i);
+            }
+
+            for (auto i = size_t{ 0 }; i < batch; i++) {
+                executor.RunOne();
+            }
+
+            for (auto&& f : futures) {
+                sum += f.get();
+            }
+        }
+    });
+
+    auto tasks = static_cast<double>(batch * rounds);
+
+    if (sum == 0)
+        std::printf("unexpected sum\n");
+
+    return result_t{ static_cast<double>(elapsed.count()) / tasks,
+                     static_cast<double>(_allocations.load() - allocations) / tasks };
+}
+}
+
+// compares taskweaver::Future with std::packaged_task + std::future
+int main()
+{
+    // no worker threads, tasks are executed by the main thread
+    auto taskManager = taskweaver::TaskManager{ 256, 0 };
+    auto& executor = taskweaver::Executor::ThreadExecutor();
+
+    auto packaged = run([&executor](size_t i) -> std::future<size_t> {
+        auto packagedTask = std::packaged_task<size_t()>{ [i]() -> size_t { return i + 1; } };
+        auto future = packagedTask.get_future();
+
+        executor.SubmitTask(std::move(packagedTask));
+
+        return future;
+    });
+
+    auto native = run([&executor](size_t i) -> taskweaver::Future<size_t> {
+        return executor.SubmitTask([i]() -> size_t { return i + 1; });
+    });
+
+    std::printf("std::packaged_task:    %.1f ns per task, %.2f allocations per task\n",
+                packaged.nsPerTask,
+                packaged.allocationsPerTask);
+    std::printf("taskweaver::Future:    %.1f ns per task, %.2f allocations per task\n",
+                native.nsPerTask,
+                native.allocationsPerTask);
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#include "../src/taskManager.h"
+#include "benchmark.h"
+
+// measures cpu consumed by idle executors and
+// latency between task submission and its start on a parked executor
+int main()
+{
+    using namespace std::chrono_literals;
+
+    constexpr auto iterations = size_t{ 1000 };
+
+    auto taskManager = taskweaver::TaskManager{};
+    taskManager.Start();
+
+    // let executors go through spinning phase
+    std::this_thread::sleep_for(100ms);
+
+    {
+        auto cpuStart = bench::cpu_time();
+        auto wallStart = bench::clock_t::now();
+
+        std::this_thread::sleep_for(1s);
+
+        auto cpu = bench::cpu_time() - cpuStart;
+        auto wall = std::chrono::duration<double>{ bench::clock_t::now() - wallStart };
+
+        std::printf("idle cpu usage: %.3f cores (%u executors)\n", cpu / wall, taskManager.ExecutorCount());
+    }
+
+    {
+        auto samples = std::vector<double>{};
+        samples.reserve(iterations);
+
+        for (auto i = size_t{ 0 }; i < iterations; i++) {
+            // long enough for executors to park again
+            std::this_thread::sleep_for(2ms);
+
+            auto submitted = bench::clock_t::now();
+            auto started = taskweaver::TaskManager::SubmitTask([]() -> bench::clock_t::time_point {
+                               return bench::clock_t::now();
+                           }).get();
+
+            samples.push_back(std::chrono::duration<double, std::micro>{ started - submitted }.count());
+        }
+
+        auto p = bench::percentiles(std::move(samples));
+        std::printf("wake up latency: median %.2f us, p99 %.2f us, max %.2f us\n", p.median, p.p99, p.max);
+    }
+
+    taskManager.Stop();
+
+    return 0;
+}
@@ -0,0 +1,53 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#include "../src/taskManager.h"
+#include "benchmark.h"
+
+// throughput of tasks posted by threads which do not own an executor
+int main()
+{
+    constexpr auto producerCount = size_t{ 4 };
+    constexpr auto tasksPerProducer = size_t{ 250000 };
+    constexpr auto taskCount = producerCount * tasksPerProducer;
+
+    auto taskManager = taskweaver::TaskManager{};
+    taskManager.Start();
+
+    auto executed = std::atomic<size_t>{ 0 };
+
+    auto elapsed = bench::measure([&taskManager, &executed]() -> void {
+        auto producers = std::vector<std::thread>{};
+        producers.reserve(producerCount);
+
+        for (auto p = size_t{ 0 }; p < producerCount; p++) {
+            producers.emplace_back([&taskManager, &executed]() -> void {
+                for (auto i = size_t{ 0 }; i < tasksPerProducer; i++) {
+                    taskManager.Post([&executed]() -> void { executed.fetch_add(1, std::memory_order_relaxed); });
+                }
+            });
+        }
+
+        for (auto&& producer : producers) {
+            producer.join();
+        }
+
+        while (executed.load(std::memory_order_relaxed) < taskCount) {
+            std::this_thread::yield();
+        }
+    });
+
+    auto seconds = std::chrono::duration<double>{ elapsed }.count();
+
+    std::printf("%zu producers, %zu tasks in %.3f s: %.2f M submits/s (%u executors)\n",
+                producerCount,
+                taskCount,
+                seconds,
+                static_cast<double>(taskCount) / seconds / 1e6,
+                taskManager.ExecutorCount());
+
+    taskManager.Stop();
+
+    return 0;
+}
@@ -0,0 +1,70 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#include "../src/taskManager.h"
+#include "benchmark.h"
+#include <cmath>
+
+namespace {
+constexpr auto tasks = size_t{ 1 } << 16;
+constexpr auto repeats = size_t{ 5 };
+
+// ~1 us of work
+auto spin(uint64_t seed) -> uint64_t
+{
+    auto x = static_cast<double>(seed);
+    for (auto i = 0; i < 200; i++) {
+        x = std::sqrt(x + 1.0);
+    }
+    return static_cast<uint64_t>(x);
+}
+
+// the main thread submits a burst of tasks and waits for them, either idle or running its executor
+void burst(bool mainThreadWorker)
+{
+    auto options = taskweaver::task_manager_options_t{ .mainThreadWorker = mainThreadWorker };
+    auto taskManager = taskweaver::TaskManager{ options };
+    taskManager.Start();
+
+    auto best = std::chrono::nanoseconds::max();
+
+    for (auto r = size_t{ 0 }; r < repeats; r++) {
+        auto done = std::atomic<size_t>{ 0 };
+        auto sink = std::atomic<uint64_t>{ 0 };
+
+        best = std::min(best, bench::measure([&taskManager, &done, &sink, mainThreadWorker]() -> void {
+            for (auto i = size_t{ 0 }; i < tasks; i++) {
+                taskweaver::TaskManager::Dispatch([&done, &sink, i]() -> void {
+                    sink.fetch_add(spin(i), std::memory_order_relaxed);
+                    done.fetch_add(1, std::memory_order_release);
+                });
+            }
+
+            if (mainThreadWorker) {
+                taskManager.RunUntil([&done]() -> bool { return done.load(std::memory_order_acquire) == tasks; });
+            } else {
+                while (done.load(std::memory_order_acquire) != tasks)
+                    std::this_thread::yield();
+            }
+        }));
+    }
+
+    auto executors = taskManager.ExecutorCount();
+    taskManager.Stop();
+
+    std::printf("%-22s %u executors, %.1f ms\n",
+                mainThreadWorker ? "main thread worker:" : "main thread waits:",
+                executors,
+                std::chrono::duration<double, std::milli>{ best }.count());
+}
+}
+
+// a burst of small tasks with hardware threads plus an idle main thread against hardware threads in total
+int main()
+{
+    burst(false);
+    burst(true);
+
+    return 0;
+}
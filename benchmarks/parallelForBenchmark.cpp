@@ -0,0 +1,63 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#include "../src/parallel.h"
+#include "benchmark.h"
+#include <cmath>
+#include <numeric>
+
+namespace {
+constexpr auto repeats = size_t{ 5 };
+
+template<typename F>
+auto best_of(F&& f) -> double
+{
+    auto best = std::chrono::nanoseconds::max();
+
+    for (auto r = size_t{ 0 }; r < repeats; r++) {
+        best = std::min(best, bench::measure(f));
+    }
+
+    return std::chrono::duration<double, std::micro>{ best }.count();
+}
+}
+
+// sequential loops against parallel_for/parallel_reduce with the default grain
+int main()
+{
+    auto taskManager = taskweaver::TaskManager{};
+    taskManager.Start();
+
+    std::printf("%u executors\n", taskManager.ExecutorCount());
+    std::printf("%10s %14s %14s %14s %14s\n", "size", "for seq, us", "for par, us", "reduce seq, us", "reduce par, us");
+
+    for (auto size = size_t{ 1000 }; size <= size_t{ 10000000 }; size *= 10) {
+        auto values = std::vector<double>(size, 1.0);
+        auto sum = 0.0;
+
+        auto forSeq = best_of([&values]() -> void {
+            for (auto& v : values) {
+                v = std::sqrt(v + 1.0);
+            }
+        });
+
+        auto forPar = best_of([&values]() -> void {
+            taskweaver::parallel_for(values.begin(), values.end(), [](double& v) -> void { v = std::sqrt(v + 1.0); });
+        });
+
+        auto reduceSeq = best_of([&values, &sum]() -> void { sum += std::accumulate(values.begin(), values.end(), 0.0); });
+
+        auto reducePar = best_of([&values, &sum]() -> void {
+            sum += taskweaver::parallel_reduce(
+              values.begin(), values.end(), 0.0, [](double a, double b) -> double { return a + b; });
+        });
+
+        std::printf("%10zu %14.1f %14.1f %14.1f %14.1f\n", size, forSeq, forPar, reduceSeq, reducePar);
+        std::printf("checksum: %f\n", sum);
+    }
+
+    taskManager.Stop();
+
+    return 0;
+}
@@ -0,0 +1,70 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#include "../src/taskManager.h"
+#include "benchmark.h"
+#include <cmath>
+
+namespace {
+constexpr auto batchTasks = size_t{ 4096 };
+constexpr auto probes = size_t{ 200 };
+
+// ~1 us of work
+auto spin(uint64_t seed) -> uint64_t
+{
+    auto x = static_cast<double>(seed);
+    for (auto i = 0; i < 200; i++) {
+        x = std::sqrt(x + 1.0);
+    }
+    return static_cast<uint64_t>(x);
+}
+
+// queueing delay of a probe task followed by a burst of batch tasks
+auto latency(taskweaver::TaskPriority probePriority) -> bench::percentiles_t
+{
+    auto& executor = taskweaver::Executor::ThreadExecutor();
+    auto sink = std::atomic<uint64_t>{ 0 };
+    auto samples = std::vector<double>{};
+    samples.reserve(probes);
+
+    for (auto p = size_t{ 0 }; p < probes; p++) {
+        auto submitted = bench::clock_t::now();
+        auto started = executor.SubmitTask(probePriority, []() -> bench::clock_t::time_point {
+            return bench::clock_t::now();
+        });
+
+        // batch work keeps coming after the probe, own lanes are popped newest first
+        for (auto i = size_t{ 0 }; i < batchTasks; i++) {
+            executor.Dispatch(taskweaver::TaskPriority::Low,
+                              [&sink, i]() -> void { sink.fetch_add(spin(i), std::memory_order_relaxed); });
+        }
+
+        samples.push_back(std::chrono::duration<double, std::micro>{ started.get() - submitted }.count());
+
+        // the rest of the backlog
+        while (executor.TryRunOne()) {
+        }
+    }
+
+    return bench::percentiles(std::move(samples));
+}
+}
+
+// latency of an interactive task sharing the task manager with batch work
+int main()
+{
+    auto taskManager = taskweaver::TaskManager{};
+    taskManager.Start();
+
+    auto low = latency(taskweaver::TaskPriority::Low);
+    auto high = latency(taskweaver::TaskPriority::High);
+
+    std::printf("%zu batch tasks after each probe (%u executors)\n", batchTasks, taskManager.ExecutorCount());
+    std::printf("same lane:  median %.1f us, p99 %.1f us, max %.1f us\n", low.median, low.p99, low.max);
+    std::printf("high lane:  median %.1f us, p99 %.1f us, max %.1f us\n", high.median, high.p99, high.max);
+
+    taskManager.Stop();
+
+    return 0;
+}
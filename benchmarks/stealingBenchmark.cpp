@@ -0,0 +1,82 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#include "../src/taskManager.h"
+#include "benchmark.h"
+#include <latch>
+
+namespace {
+// fine-grained fan-out, every task spawns two children until the leaves
+void spawn(uint32_t depth, std::latch& leaves)
+{
+    if (depth == 0) {
+        leaves.count_down();
+        return;
+    }
+
+    taskweaver::TaskManager::SubmitTask([depth, &leaves]() -> void { spawn(depth - 1, leaves); });
+    taskweaver::TaskManager::SubmitTask([depth, &leaves]() -> void { spawn(depth - 1, leaves); });
+}
+}
+
+int main()
+{
+    constexpr auto depth = uint32_t{ 16 };
+    constexpr auto rounds = size_t{ 20 };
+
+    auto taskManager = taskweaver::TaskManager{};
+    taskManager.Start();
+
+    auto elapsed = std::chrono::nanoseconds{ 0 };
+
+    for (auto i = size_t{ 0 }; i < rounds; i++) {
+        auto leaves = std::latch{ std::ptrdiff_t{ 1 } << depth };
+
+        elapsed += bench::measure([&leaves]() -> void {
+            taskweaver::TaskManager::SubmitTask([&leaves]() -> void { spawn(depth, leaves); });
+            leaves.wait();
+        });
+    }
+
+    auto tasks = rounds * ((size_t{ 2 } << depth) - 1);
+
+    std::printf("%zu tasks in %.3f ms, %.1f ns per task (%u executors)\n",
+                tasks,
+                std::chrono::duration<double, std::milli>{ elapsed }.count(),
+                static_cast<double>(elapsed.count()) / static_cast<double>(tasks),
+                taskManager.ExecutorCount());
+
+#if defined(TASKWEAVER_STATISTICS)
+    auto counters = taskManager.Stats();
+    auto const& stats = counters.steals;
+
+    std::printf("steal attempts: %llu, successful steals: %llu, stolen tasks: %llu, tasks per steal: %.2f\n",
+                static_cast<unsigned long long>(stats.attempts),
+                static_cast<unsigned long long>(stats.steals),
+                static_cast<unsigned long long>(stats.stolenTasks),
+                stats.steals > 0 ? static_cast<double>(stats.stolenTasks) / static_cast<double>(stats.steals) : 0.0);
+
+    std::printf("sharing l3: %llu, same numa node: %llu, other nodes: %llu\n",
+                static_cast<unsigned long long>(stats.localSteals),
+                static_cast<unsigned long long>(stats.steals - stats.localSteals - stats.remoteSteals),
+                static_cast<unsigned long long>(stats.remoteSteals));
+
+    std::printf("executed: %llu, local pops: %llu, pool growths: %llu, queue growths: %llu, max depth: %llu\n",
+                static_cast<unsigned long long>(counters.executedTasks),
+                static_cast<unsigned long long>(counters.localPops),
+                static_cast<unsigned long long>(counters.poolGrowths),
+                static_cast<unsigned long long>(counters.queueGrowths),
+                static_cast<unsigned long long>(counters.maxQueueDepth));
+    std::printf("idle rounds: %llu, parks: %llu, parked: %.3f ms\n",
+                static_cast<unsigned long long>(counters.idleRounds),
+                static_cast<unsigned long long>(counters.parks),
+                static_cast<double>(counters.parkedTime) / 1e6);
+#else
+    std::printf("steal and scheduler counters need -DSTATISTICS=ON\n");
+#endif
+
+    taskManager.Stop();
+
+    return 0;
+}
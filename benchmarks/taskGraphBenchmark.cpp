@@ -0,0 +1,76 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#include "../src/taskGraph.h"
+#include "benchmark.h"
+
+namespace {
+constexpr auto layers = size_t{ 100 };
+constexpr auto width = size_t{ 100 };
+
+// layered DAG, every node depends on two nodes of the previous layer
+void build(taskweaver::TaskGraph& graph, std::vector<uint64_t>& values)
+{
+    for (auto layer = size_t{ 0 }; layer < layers; layer++) {
+        for (auto i = size_t{ 0 }; i < width; i++) {
+            auto id = layer * width + i;
+            auto left = (layer - 1) * width + i;
+            auto right = (layer - 1) * width + (i + 1) % width;
+
+            auto node = graph.Emplace([&values, id, left, right, layer]() -> void {
+                values[id] += (layer > 0) ? (values[left] ^ values[right]) + id : id;
+            });
+
+            if (layer > 0) {
+                graph.Precede(left, node);
+                graph.Precede(right, node);
+            }
+        }
+    }
+}
+}
+
+int main()
+{
+    constexpr auto rounds = size_t{ 200 };
+
+    auto taskManager = taskweaver::TaskManager{};
+    taskManager.Start();
+
+    auto values = std::vector<uint64_t>(layers * width, 0);
+    auto graph = taskweaver::TaskGraph{};
+
+    auto construction = bench::measure([&graph, &values]() -> void { build(graph, values); });
+
+    // the first run prepares the successor lists
+    auto first = bench::measure([&graph]() -> void { graph.Run().get(); });
+
+    auto samples = std::vector<double>{};
+    samples.reserve(rounds);
+
+    for (auto r = size_t{ 0 }; r < rounds; r++) {
+        auto elapsed = bench::measure([&graph]() -> void { graph.Run().get(); });
+        samples.push_back(std::chrono::duration<double, std::micro>{ elapsed }.count());
+    }
+
+    auto p = bench::percentiles(samples);
+
+    std::printf("%zu nodes, construction: %.1f us, first run: %.1f us (%u executors)\n",
+                graph.Size(),
+                std::chrono::duration<double, std::micro>{ construction }.count(),
+                std::chrono::duration<double, std::micro>{ first }.count(),
+                taskManager.ExecutorCount());
+
+    std::printf("re-run: median %.1f us, p99 %.1f us, max %.1f us, %.1f ns per node\n",
+                p.median,
+                p.p99,
+                p.max,
+                p.median * 1000.0 / static_cast<double>(graph.Size()));
+
+    std::printf("checksum: %llu\n", static_cast<unsigned long long>(values.back()));
+
+    taskManager.Stop();
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#include "../src/taskManager.h"
+#include "benchmark.h"
+
+// SubmitTask latency depending on how many slots of the executor pool are already taken
+int main()
+{
+    constexpr auto taskQueueSize = size_t{ 512 };
+    constexpr auto repeats = size_t{ 2000 };
+    constexpr auto fillLevels = std::array<size_t, 6>{ 0, 64, 128, 256, 448, 510 };
+
+    // no worker threads, so submitted tasks stay in the pool until main thread runs them
+    auto taskManager = taskweaver::TaskManager{ taskQueueSize, 0 };
+    auto& executor = taskweaver::Executor::ThreadExecutor();
+
+    auto counter = uint64_t{ 0 };
+    auto increment = [&counter]() -> void { counter++; };
+
+    for (auto fillLevel : fillLevels) {
+        auto samples = std::vector<double>{};
+        samples.reserve(repeats);
+
+        for (auto r = size_t{ 0 }; r < repeats; r++) {
+            for (auto i = size_t{ 0 }; i < fillLevel; i++) {
+                executor.SubmitTask(increment);
+            }
+
+            auto elapsed = bench::measure([&executor, &increment]() -> void { executor.SubmitTask(increment); });
+            samples.push_back(static_cast<double>(elapsed.count()));
+
+            for (auto i = size_t{ 0 }; i <= fillLevel; i++) {
+                executor.RunOne();
+            }
+        }
+
+        auto p = bench::percentiles(std::move(samples));
+        std::printf("pool fill %4zu/%zu: SubmitTask median %.0f ns, p99 %.0f ns\n",
+                    fillLevel,
+                    taskQueueSize * 2,
+                    p.median,
+                    p.p99);
+    }
+
+    std::printf("tasks executed: %llu\n", static_cast<unsigned long long>(counter));
+
+    return 0;
+}
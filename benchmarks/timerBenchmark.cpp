@@ -0,0 +1,109 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#include "../src/taskManager.h"
+#include "benchmark.h"
+
+namespace {
+constexpr auto timerCount = size_t{ 100'000 };
+
+using clock_t = taskweaver::TimerWheel::clock_t;
+
+// insert and cancel cost with many outstanding timers
+void insertCancel()
+{
+    auto wheel = taskweaver::TimerWheel{};
+    auto handles = std::vector<taskweaver::TimerHandle>{};
+    handles.reserve(timerCount);
+
+    auto now = clock_t::now();
+
+    auto insert = bench::measure([&wheel, &handles, now]() -> void {
+        for (auto i = size_t{ 0 }; i < timerCount; i++) {
+            auto* timer = new taskweaver::internal::timer_node_t{ wheel, 0, []() -> void {} };
+            timer->add_ref();
+            handles.emplace_back(timer);
+
+            // spread over all the levels of the wheel
+            wheel.Insert(timer, now + std::chrono::milliseconds{ (i * 7919) % 10'000'000 });
+        }
+    });
+
+    auto cancel = bench::measure([&handles]() -> void {
+        for (auto& handle : handles) {
+            handle.cancel();
+        }
+    });
+
+    std::printf("%zu timers: insert %.1f ns, cancel %.1f ns per timer\n",
+                timerCount,
+                static_cast<double>(insert.count()) / timerCount,
+                static_cast<double>(cancel.count()) / timerCount);
+}
+
+// how late delayed tasks run when many of them are outstanding
+void lateness()
+{
+    auto taskManager = taskweaver::TaskManager{};
+    taskManager.Start();
+
+    auto late = std::vector<double>(timerCount);
+    auto futures = std::vector<taskweaver::Future<void>>{};
+    futures.reserve(timerCount);
+
+    for (auto i = size_t{ 0 }; i < timerCount; i++) {
+        auto delay = std::chrono::milliseconds{ 1 + i % 500 };
+        auto deadline = clock_t::now() + delay;
+
+        futures.push_back(taskManager.SubmitAfter(delay, [&late, i, deadline]() -> void {
+            late[i] = std::chrono::duration<double, std::micro>{ clock_t::now() - deadline }.count();
+        }));
+    }
+
+    for (auto& future : futures) {
+        future.wait();
+    }
+
+    auto p = bench::percentiles(std::move(late));
+    std::printf("%zu delayed tasks: lateness median %.0f us, p99 %.0f us, max %.0f us (%u executors)\n",
+                timerCount,
+                p.median,
+                p.p99,
+                p.max,
+                taskManager.ExecutorCount());
+
+    taskManager.Stop();
+}
+
+// a sleeping task manager with a periodic timer, the watcher wakes up only on deadlines
+void idle()
+{
+    using namespace std::chrono_literals;
+
+    auto taskManager = taskweaver::TaskManager{};
+    taskManager.Start();
+
+    auto runs = std::atomic<uint32_t>{ 0 };
+    auto handle = taskManager.SubmitEvery(10ms, [&runs]() -> void { runs.fetch_add(1); });
+
+    auto cpuBefore = bench::cpu_time();
+    std::this_thread::sleep_for(1s);
+    auto cpu = bench::cpu_time() - cpuBefore;
+
+    handle.cancel();
+
+    std::printf("10 ms periodic task for 1 s: %u runs, %.1f ms cpu\n", runs.load(), cpu.count() * 1000.0);
+
+    taskManager.Stop();
+}
+}
+
+int main()
+{
+    insertCancel();
+    lateness();
+    idle();
+
+    return 0;
+}
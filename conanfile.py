@@ -12,7 +12,7 @@ class TaskWeaverRecipe(ConanFile):
 
     settings = "os", "compiler", "arch", "build_type"
 
-    exports_sources = "CMakeLists.txt", "*.cmake", ".clang-format", ".md", "src/*.cpp", "src/*.h", "tests/*", "cmake/*"
+    exports_sources = "CMakeLists.txt", "*.cmake", ".clang-format", ".md", "src/*.cpp", "src/*.h", "tests/*", "benchmarks/*", "cmake/*"
 
     def build_requirements(self):
         self.tool_requires("cmake/[>=3.10]")
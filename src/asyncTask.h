@@ -0,0 +1,296 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#ifndef TASKWEAVER_ASYNCTASK_H
+#define TASKWEAVER_ASYNCTASK_H
+
+#include "common.h"
+#include "taskManager.h"
+#include <coroutine>
+
+namespace taskweaver {
+template<typename T>
+class AsyncTask;
+
+namespace internal {
+// coroutine frames are allocated from the slab of the thread which calls the coroutine,
+// so, like futures, they must not outlive the task manager
+struct coroutine_frame_allocation_t
+{
+    static auto operator new(size_t size) -> void* { return SlabAllocator::ThreadAllocate(size); }
+
+    static void operator delete(void* p) noexcept { SlabAllocator::Deallocate(p); }
+};
+
+inline void resume_coroutine(void* address)
+{
+    std::coroutine_handle<>::from_address(address).resume();
+}
+
+struct async_promise_base_t : coroutine_frame_allocation_t
+{
+    // resumes the awaiting coroutine, if there is any, without growing the stack
+    struct final_awaiter_t
+    {
+        [[nodiscard]] auto await_ready() const noexcept -> bool { return false; }
+
+        template<typename Promise>
+        auto await_suspend(std::coroutine_handle<Promise> handle) noexcept -> std::coroutine_handle<>
+        {
+            if (auto continuation = handle.promise().continuation_)
+                return continuation;
+
+            return std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    // lazy start: the coroutine runs when it is awaited
+    [[nodiscard]] auto initial_suspend() const noexcept -> std::suspend_always { return {}; }
+
+    [[nodiscard]] auto final_suspend() const noexcept -> final_awaiter_t { return {}; }
+
+    void unhandled_exception() { exception_ = std::current_exception(); }
+
+    void rethrow_if_exception() const
+    {
+        if (exception_)
+            std::rethrow_exception(exception_);
+    }
+
+    std::coroutine_handle<> continuation_;
+    std::exception_ptr exception_;
+};
+
+template<typename T>
+struct async_promise_t : async_promise_base_t
+{
+    auto get_return_object() -> AsyncTask<T>;
+
+    template<typename U>
+    void return_value(U&& value)
+    {
+        value_.emplace(std::forward<U>(value));
+    }
+
+    auto result() -> T
+    {
+        rethrow_if_exception();
+        return std::move(value_.value());
+    }
+
+    std::optional<T> value_;
+};
+
+template<>
+struct async_promise_t<void> : async_promise_base_t
+{
+    auto get_return_object() -> AsyncTask<void>;
+
+    void return_void() {}
+
+    void result() { rethrow_if_exception(); }
+};
+
+// suspends the coroutine until the future is ready, the coroutine is resumed
+// by a task in the deque of the executor which completes the future
+template<typename T>
+struct future_awaiter_t : future_continuation_t
+{
+    explicit future_awaiter_t(Future<T>&& future)
+      : future_continuation_t{ &on_ready }
+      , future_{ std::move(future) }
+      , handle_{}
+      , fallback_{ nullptr }
+    {
+    }
+
+    [[nodiscard]] auto await_ready() const -> bool { return future_.is_ready(); }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        handle_ = handle;
+        fallback_ = current_executor();
+
+        // the coroutine may be resumed by another thread before the call returns
+        future_.set_continuation(*this);
+    }
+
+    auto await_resume() -> T { return future_.get(); }
+
+    static void on_ready(future_continuation_t* continuation)
+    {
+        auto* awaiter = static_cast<future_awaiter_t*>(continuation);
+        schedule_continuation(&resume_coroutine, awaiter->handle_.address(), awaiter->fallback_);
+    }
+
+    Future<T> future_;
+    std::coroutine_handle<> handle_;
+    Executor* fallback_;
+};
+
+// detached coroutine which runs an async task and passes the result to the promise
+struct async_spawn_t
+{
+    struct promise_type : coroutine_frame_allocation_t
+    {
+        [[nodiscard]] auto get_return_object() const noexcept -> async_spawn_t { return {}; }
+
+        [[nodiscard]] auto initial_suspend() const noexcept -> std::suspend_never { return {}; }
+
+        [[nodiscard]] auto final_suspend() const noexcept -> std::suspend_never { return {}; }
+
+        void return_void() const noexcept {}
+
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+template<typename T>
+auto spawn(AsyncTask<T> task, Promise<T> promise) -> async_spawn_t
+{
+    try {
+        if constexpr (std::is_void_v<T>) {
+            co_await std::move(task);
+            promise.set_value();
+        } else {
+            promise.set_value(co_await std::move(task));
+        }
+    } catch (...) {
+        promise.set_exception(std::current_exception());
+    }
+}
+} // internal
+
+// coroutine task, named so since Task is the type-erased callable stored in executor deques:
+// the coroutine starts lazily when it is awaited, co_await on another async task transfers control to it
+// and back without scheduling, co_await on a future or on schedule() suspends the coroutine and
+// resumes it as a task of an executor, so no thread blocks while the coroutine waits
+template<typename T = void>
+class [[nodiscard]] AsyncTask
+{
+public:
+    using promise_type = internal::async_promise_t<T>;
+    using handle_t = std::coroutine_handle<promise_type>;
+
+    AsyncTask()
+      : handle_{}
+    {
+    }
+
+    AsyncTask(AsyncTask const&) = delete;
+
+    AsyncTask(AsyncTask&& other) noexcept
+      : handle_{ std::exchange(other.handle_, nullptr) }
+    {
+    }
+
+    ~AsyncTask()
+    {
+        if (handle_)
+            handle_.destroy();
+    }
+
+    auto operator=(AsyncTask const&) -> AsyncTask& = delete;
+
+    auto operator=(AsyncTask&& rhs) noexcept -> AsyncTask&
+    {
+        if (this != &rhs) {
+            if (handle_)
+                handle_.destroy();
+
+            handle_ = std::exchange(rhs.handle_, nullptr);
+        }
+
+        return *this;
+    }
+
+    [[nodiscard]] auto valid() const -> bool { return static_cast<bool>(handle_); }
+
+    auto operator co_await() && noexcept
+    {
+        struct awaiter_t
+        {
+            [[nodiscard]] auto await_ready() const noexcept -> bool { return handle_.done(); }
+
+            // symmetric transfer: the awaited coroutine starts in place
+            auto await_suspend(std::coroutine_handle<> awaiting) noexcept -> std::coroutine_handle<>
+            {
+                handle_.promise().continuation_ = awaiting;
+                return handle_;
+            }
+
+            auto await_resume() -> T { return handle_.promise().result(); }
+
+            handle_t handle_;
+        };
+
+        assert(valid());
+        return awaiter_t{ handle_ };
+    }
+
+private:
+    friend promise_type;
+
+    explicit AsyncTask(handle_t handle)
+      : handle_{ handle }
+    {
+    }
+
+private:
+    handle_t handle_;
+};
+
+template<typename T>
+auto internal::async_promise_t<T>::get_return_object() -> AsyncTask<T>
+{
+    return AsyncTask<T>{ std::coroutine_handle<async_promise_t>::from_promise(*this) };
+}
+
+inline auto internal::async_promise_t<void>::get_return_object() -> AsyncTask<void>
+{
+    return AsyncTask<void>{ std::coroutine_handle<async_promise_t>::from_promise(*this) };
+}
+
+template<typename T>
+auto operator co_await(Future<T>&& future) -> internal::future_awaiter_t<T>
+{
+    return internal::future_awaiter_t<T>{ std::move(future) };
+}
+
+// co_await schedule() moves the coroutine into the deque of the current executor, so thieves can take it,
+// a thread without executor continues in place
+[[nodiscard]] inline auto schedule() noexcept
+{
+    struct awaiter_t
+    {
+        [[nodiscard]] auto await_ready() const noexcept -> bool { return !Executor::HasThreadExecutor(); }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            internal::schedule_continuation(&internal::resume_coroutine, handle.address(), nullptr);
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    return awaiter_t{};
+}
+
+// starts the async task in the calling thread until its first suspension,
+// the result is available via the returned future
+template<typename T>
+auto Spawn(AsyncTask<T> task) -> Future<T>
+{
+    auto promise = Promise<T>{};
+    auto future = promise.get_future();
+
+    internal::spawn(std::move(task), std::move(promise));
+
+    return future;
+}
+}
+
+#endif // TASKWEAVER_ASYNCTASK_H
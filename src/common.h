@@ -14,12 +14,17 @@
 #include <new>
 #include <thread>
 #include <type_traits>
+#include <vector>
 
 #if defined(ALLOW_THREAD_EXCEPTIONS_PROPAGATION)
 #include <exception>
 #include <mutex>
 #endif // ALLOW_THREAD_EXCEPTIONS_PROPAGATION
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 #ifdef __cpp_lib_hardware_interference_size
 using std::hardware_constructive_interference_size;
 using std::hardware_destructive_interference_size;
@@ -40,4 +45,16 @@ auto make_unique_for_overwrite(size_t n) -> std::enable_if_t<is_unbounded_array<
 }
 #endif
 
+// hints the cpu that the calling thread is in a spin-wait loop
+inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#elif defined(_MSC_VER)
+    _mm_pause();
+#endif
+}
+
 #endif // TASKWEAVER_COMMON_H
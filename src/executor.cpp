@@ -4,8 +4,16 @@
 
 #include "executor.h"
 #include "taskManager.h"
+#include <limits>
 #include <random>
 
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <ctime>
+#endif
+
 #if defined(ALLOW_THREAD_EXCEPTIONS_PROPAGATION)
 #define BEGIN_EXCEPTION_PROPAGATION() try {
 
@@ -20,10 +28,160 @@
 #define END_EXCEPTION_PROPAGATION()
 #endif
 
+#if defined(TASKWEAVER_STATISTICS)
+#define COUNT_EVENT(counter, ...) increment(counters_.counter __VA_OPT__(, ) __VA_ARGS__)
+#else
+#define COUNT_EVENT(counter, ...)
+#endif
+
 namespace taskweaver {
 namespace {
 thread_local Executor* _mainThreadExecutor = nullptr;
 thread_local Executor* _threadExecutor = nullptr;
+
+// an idle executor keeps looking for work for a while before it goes to sleep,
+// it keeps wake up latency low for bursty workloads
+constexpr auto idle_spin_rounds_v = uint32_t{ 64 };
+constexpr auto idle_yield_rounds_v = uint32_t{ 16 };
+
+constexpr auto executor_running_v = uint32_t{ 0 };
+constexpr auto executor_parked_v = uint32_t{ 1 };
+
+// every 4th pick starts from the normal lane, every 16th one from the low lane and so on,
+// so under a flood of high priority tasks a lower lane still gets a fixed share of the executor
+constexpr auto lane_rotation_period_v = uint64_t{ 4 };
+
+// busy executors look at the timers every few picks, idle ones on every pick
+constexpr auto timer_poll_period_v = uint64_t{ 64 };
+
+constexpr auto distance_cache_v = size_t{ 0 };
+constexpr auto distance_node_v = size_t{ 1 };
+constexpr auto distance_remote_v = size_t{ 2 };
+
+auto distance(cpu_info_t const& a, cpu_info_t const& b) -> size_t
+{
+    if (a.node != b.node || a.package != b.package)
+        return distance_remote_v;
+
+    return (a.l3 == b.l3) ? distance_cache_v : distance_node_v;
+}
+
+// the first lane, then the others from the highest priority down
+auto lane_at(size_t firstLane, size_t i) -> size_t
+{
+    if (i == 0)
+        return firstLane;
+
+    return i <= firstLane ? i - 1 : i;
+}
+
+#if defined(TASKWEAVER_STATISTICS)
+// relaxed increment, counter is written by the single thread
+void increment(std::atomic<uint64_t>& counter, uint64_t value = 1)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+#endif
+
+// the reference of the wheel to a firing periodic timer,
+// travels with the task, so a dropped or throwing task releases the timer
+struct timer_ref_t
+{
+    explicit timer_ref_t(internal::timer_node_t* timer)
+      : timer_{ timer }
+    {
+    }
+
+    timer_ref_t(timer_ref_t const&) = delete;
+
+    timer_ref_t(timer_ref_t&& other) noexcept
+      : timer_{ std::exchange(other.timer_, nullptr) }
+    {
+    }
+
+    ~timer_ref_t()
+    {
+        if (timer_ != nullptr)
+            timer_->release();
+    }
+
+    auto operator=(timer_ref_t const&) -> timer_ref_t& = delete;
+
+    auto operator=(timer_ref_t&&) -> timer_ref_t& = delete;
+
+    [[nodiscard]] auto get() const -> internal::timer_node_t* { return timer_; }
+
+    auto take() -> internal::timer_node_t* { return std::exchange(timer_, nullptr); }
+
+private:
+    internal::timer_node_t* timer_;
+};
+}
+
+// on linux it is a futex wait with the absolute deadline of the monotonic clock (the one of steady_clock)
+void internal::park_wait(std::atomic<uint32_t>& state, uint32_t parked, std::chrono::steady_clock::time_point deadline)
+{
+#if defined(__linux__)
+    auto timeout = timespec{};
+    auto hasDeadline = deadline != std::chrono::steady_clock::time_point::max();
+
+    if (hasDeadline) {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+        timeout.tv_sec = static_cast<time_t>(ns / 1'000'000'000);
+        timeout.tv_nsec = static_cast<long>(ns % 1'000'000'000);
+    }
+
+    ::syscall(SYS_futex,
+              reinterpret_cast<uint32_t*>(&state),
+              FUTEX_WAIT_BITSET_PRIVATE,
+              parked,
+              hasDeadline ? &timeout : nullptr,
+              nullptr,
+              FUTEX_BITSET_MATCH_ANY);
+
+    // pairs with the release of Unpark
+    [[maybe_unused]] auto value = state.load(std::memory_order_acquire);
+#else
+    if (deadline == std::chrono::steady_clock::time_point::max()) {
+        state.wait(parked, std::memory_order_acquire);
+        return;
+    }
+
+    // there is no timed atomic wait, so the watcher naps and the caller parks again
+    auto nap = std::min<std::chrono::steady_clock::duration>(deadline - std::chrono::steady_clock::now(), TimerWheel::tick_v);
+    if (nap > std::chrono::steady_clock::duration::zero())
+        std::this_thread::sleep_for(nap);
+#endif
+}
+
+void internal::park_notify(std::atomic<uint32_t>& state)
+{
+#if defined(__linux__)
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&state), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+    state.notify_one();
+#endif
+}
+
+void internal::park_notify_all(std::atomic<uint32_t>& state)
+{
+#if defined(__linux__)
+    ::syscall(SYS_futex,
+              reinterpret_cast<uint32_t*>(&state),
+              FUTEX_WAKE_PRIVATE,
+              std::numeric_limits<int>::max(),
+              nullptr,
+              nullptr,
+              0);
+#else
+    state.notify_all();
+#endif
+}
+
+auto internal::task_cancelled_exception() -> std::exception_ptr const&
+{
+    static auto const exception = std::make_exception_ptr(TaskCancelledError{});
+    return exception;
 }
 
 /*static*/ auto Executor::IsInMainThread() -> bool
@@ -37,13 +195,75 @@ thread_local Executor* _threadExecutor = nullptr;
     return *_threadExecutor;
 }
 
-Executor::Executor(taskweaver::TaskManager& taskManager, size_t taskDequeSize)
+/*static*/ auto Executor::HasThreadExecutor() -> bool
+{
+    return _threadExecutor != nullptr;
+}
+
+Executor::Executor(taskweaver::TaskManager& taskManager,
+                   size_t index,
+                   size_t taskDequeSize,
+                   cpu_info_t const& placement)
   : threadId_{}
   , taskManager_{ &taskManager }
-  , taskPool_{ taskDequeSize * 2 } // max tasks per executor
-  , taskQueue_{ nullptr }
+  , index_{ index }
+  , placement_{ placement }
+  , lastVictim_{ index }
+  , victims_{}
+  , victimsEnd_{}
+  , failedLocalSteals_{ 0 }
+  , random_{ 0 }
+  , slab_{}
+  , taskPool_{ taskDequeSize * 2 } // initial tasks per executor, pool grows on demand
+  , taskQueues_{}
+  , picks_{ 0 }
+#if defined(TASKWEAVER_TRACING)
+  , trace_{ taskManager.traceBufferSize_ }
+  , traceTag_{ nullptr }
+#endif
+  , idleRounds_{ 0 }
+  , parkState_{ executor_running_v }
+{
+    for (auto& queue : taskQueues_) {
+        queue = std::make_unique<TaskStealingDeque<Task*>>(taskDequeSize);
+    }
+
+    auto seed = std::random_device{};
+    random_ = (static_cast<uint64_t>(seed()) << 32 | seed()) | 1; // xorshift state must not be zero
+}
+
+auto Executor::Stats() const -> executor_stats_t
+{
+    auto stats = executor_stats_t{};
+
+#if defined(TASKWEAVER_STATISTICS)
+    stats.steals = steal_stats_t{ counters_.stealAttempts.load(std::memory_order_relaxed),
+                                  counters_.steals.load(std::memory_order_relaxed),
+                                  counters_.stolenTasks.load(std::memory_order_relaxed),
+                                  counters_.localSteals.load(std::memory_order_relaxed),
+                                  counters_.remoteSteals.load(std::memory_order_relaxed) };
+    stats.executedTasks = counters_.executedTasks.load(std::memory_order_relaxed);
+    stats.localPops = counters_.localPops.load(std::memory_order_relaxed);
+    stats.injectedTasks = counters_.injectedTasks.load(std::memory_order_relaxed);
+    stats.poolGrowths = counters_.poolGrowths.load(std::memory_order_relaxed);
+    stats.queueGrowths = counters_.queueGrowths.load(std::memory_order_relaxed);
+    stats.maxQueueDepth = counters_.maxQueueDepth.load(std::memory_order_relaxed);
+    stats.idleRounds = counters_.idleRounds.load(std::memory_order_relaxed);
+    stats.parks = counters_.parks.load(std::memory_order_relaxed);
+    stats.parkedTime = counters_.parkedTime.load(std::memory_order_relaxed);
+#endif
+
+    return stats;
+}
+
+auto Executor::IsQueueEmpty() const -> bool
 {
-    taskQueue_ = std::make_unique<TaskStealingDeque<Task*>>(taskDequeSize);
+    for (auto lane = size_t{ 0 }; lane < task_priority_count_v; lane++) {
+        if (!Queue(lane).IsEmpty())
+            return false;
+    }
+
+    return true;
 }
 
 auto Executor::CanSubmit() const -> bool
@@ -54,13 +274,252 @@ auto Executor::CanSubmit() const -> bool
 
 void Executor::RunOne()
 {
-    if (auto task = PendingTask()) {
-        task.value()();
+    if (TryRunOne()) {
+        idleRounds_ = 0;
+    } else {
+        Idle();
+    }
+}
+
+auto Executor::TryRunOne() -> bool
+{
+    auto* task = PendingTask();
+
+    if (task == nullptr)
+        return false;
+
+    // the task runs in its pool slot, the slot is released on any way out
+    auto release = std::unique_ptr<Task, void (*)(Task*)>{
+        task, [](Task* t) -> void { Executor::ThreadExecutor().ReleaseTask(t); }
+    };
+
+    BEGIN_EXCEPTION_PROPAGATION();
+
+#if defined(TASKWEAVER_TRACING)
+    // the only cost of the tracing while it is off
+    if (TaskManager().IsTracing()) [[unlikely]] {
+        RunTraced(*task);
     } else {
+        (*task)();
+    }
+#else
+    (*task)();
+#endif
+
+    END_EXCEPTION_PROPAGATION();
+
+    COUNT_EVENT(executedTasks);
+
+    return true;
+}
+
+#if defined(TASKWEAVER_TRACING)
+void Executor::RunTraced(Task& task)
+{
+    // the event is recorded on any way out, nested tasks run inside have own tags
+    struct span_t
+    {
+        ~span_t()
+        {
+            executor.trace_.Record(
+              trace_event_t{ begin, executor.TraceNow(), executor.traceTag_, TraceEventType::Task, 0 });
+            executor.traceTag_ = outerTag;
+        }
+
+        Executor& executor;
+        int64_t begin;
+        char const* outerTag;
+    };
+
+    auto span = span_t{ *this, TraceNow(), std::exchange(traceTag_, nullptr) };
+
+    task();
+}
+
+void Executor::RecordTrace(TraceEventType type, int64_t begin, uint32_t arg)
+{
+    trace_.Record(trace_event_t{ begin, TraceNow(), nullptr, type, arg });
+}
+
+auto Executor::TraceNow() const -> int64_t
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                 TaskManager().traceEpoch_)
+      .count();
+}
+#endif
+
+void Executor::RunUntil(std::chrono::steady_clock::time_point deadline)
+{
+    assert(CanSubmit());
+
+    for (auto now = std::chrono::steady_clock::now(); now < deadline; now = std::chrono::steady_clock::now()) {
+        if (TryRunOne()) {
+            idleRounds_ = 0;
+        } else {
+            Idle(deadline - now);
+        }
+    }
+}
+
+void Executor::HelpUntilReady(internal::future_state_base_t const& state,
+                              std::chrono::steady_clock::time_point deadline /* = time_point::max()*/)
+{
+    // the same spin-then-park policy as in Idle, but with own counter:
+    // executor may help while waiting inside a task, run by RunOne
+    auto idleRounds = uint32_t{ 0 };
+    auto timed = deadline != std::chrono::steady_clock::time_point::max();
+
+    while (!state.is_ready()) {
+        if (timed && std::chrono::steady_clock::now() >= deadline)
+            return;
+
+        if (TryRunOne()) {
+            idleRounds = 0;
+        } else if (idleRounds < idle_spin_rounds_v) {
+            cpu_relax();
+            idleRounds++;
+            COUNT_EVENT(idleRounds);
+        } else if (idleRounds < idle_spin_rounds_v + idle_yield_rounds_v) {
+            std::this_thread::yield();
+            idleRounds++;
+            COUNT_EVENT(idleRounds);
+        } else {
+            Park(&state, deadline);
+            idleRounds = 0;
+        }
+    }
+}
+
+void Executor::Idle(std::chrono::steady_clock::duration timeout /* = duration::max()*/)
+{
+    if (idleRounds_ < idle_spin_rounds_v) {
+        cpu_relax();
+    } else if (idleRounds_ < idle_spin_rounds_v + idle_yield_rounds_v) {
         std::this_thread::yield();
+    } else {
+        auto until = (timeout == std::chrono::steady_clock::duration::max())
+                       ? std::chrono::steady_clock::time_point::max()
+                       : std::chrono::steady_clock::now() + timeout;
+
+        Park(nullptr, until);
+        idleRounds_ = 0;
+        return;
     }
+
+    idleRounds_++;
+    COUNT_EVENT(idleRounds);
 }
 
+void Executor::Park(internal::future_state_base_t const* awaited /* = nullptr*/,
+                    std::chrono::steady_clock::time_point until /* = time_point::max()*/)
+{
+    auto& taskManager = TaskManager();
+
+    parkState_.store(executor_parked_v, std::memory_order_seq_cst);
+    taskManager.parkedCount_.fetch_add(1, std::memory_order_seq_cst);
+
+    // the first parked executor sleeps until the next timer deadline, the others until they are woken up
+    auto* noWatcher = std::add_pointer_t<Executor>{ nullptr };
+    auto watcher = taskManager.timerWatcher_.compare_exchange_strong(noWatcher, this, std::memory_order_seq_cst);
+
+    // pairs with the fences in TaskManager::NotifyOne and TaskManager::WakeTimerWatcher:
+    // either submitter sees this executor parked or this executor sees submitted task or timer
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    auto deadline = watcher ? taskManager.Timers().NextDeadline() : TimerWheel::clock_t::time_point::max();
+    deadline = std::min(deadline, until);
+
+    if (taskManager.KeepAlive() && !taskManager.HasPendingTasks() && (awaited == nullptr || !awaited->is_ready()) &&
+        (deadline == TimerWheel::clock_t::time_point::max() || deadline > TimerWheel::clock_t::now())) {
+#if defined(TASKWEAVER_STATISTICS)
+        auto parkedAt = std::chrono::steady_clock::now();
+#endif
+
+#if defined(TASKWEAVER_TRACING)
+        auto tracing = taskManager.IsTracing();
+        auto parkBegin = tracing ? TraceNow() : int64_t{ 0 };
+#endif
+
+        internal::park_wait(parkState_, executor_parked_v, deadline);
+
+#if defined(TASKWEAVER_TRACING)
+        if (tracing)
+            RecordTrace(TraceEventType::Park, parkBegin);
+#endif
+
+#if defined(TASKWEAVER_STATISTICS)
+        auto parked = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - parkedAt);
+        COUNT_EVENT(parks);
+        COUNT_EVENT(parkedTime, static_cast<uint64_t>(parked.count()));
+#endif
+    }
+
+    if (watcher)
+        taskManager.timerWatcher_.store(nullptr, std::memory_order_relaxed);
+
+    taskManager.parkedCount_.fetch_sub(1, std::memory_order_relaxed);
+    parkState_.store(executor_running_v, std::memory_order_relaxed);
+}
+
+void Executor::UnparkAll()
+{
+    TaskManager().NotifyAll();
+}
+
+auto Executor::Unpark() -> bool
+{
+    auto expected = executor_parked_v;
+
+    if (parkState_.compare_exchange_strong(
+          expected, executor_running_v, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+        internal::park_notify(parkState_);
+        return true;
+    }
+
+    return false;
+}
+
+void Executor::NotifyTaskSubmitted()
+{
+#if defined(TASKWEAVER_STATISTICS)
+    CountSubmission();
+#endif
+
+    TaskManager().NotifyOne();
+}
+
+#if defined(TASKWEAVER_STATISTICS)
+void Executor::CountSubmission()
+{
+    // the pool and the rings only grow, so a changed size means a growth since the previous submission
+    if (auto size = Pool().Size(); size != counters_.poolSize) {
+        if (counters_.poolSize != 0)
+            COUNT_EVENT(poolGrowths);
+
+        counters_.poolSize = size;
+    }
+
+    auto depth = size_t{ 0 };
+
+    for (auto lane = size_t{ 0 }; lane < task_priority_count_v; lane++) {
+        auto& queue = Queue(lane);
+
+        if (auto capacity = queue.Capacity(); capacity != counters_.queueCapacities[lane]) {
+            if (counters_.queueCapacities[lane] != 0)
+                COUNT_EVENT(queueGrowths);
+
+            counters_.queueCapacities[lane] = capacity;
+        }
+
+        depth += queue.Size();
+    }
+
+    if (depth > counters_.maxQueueDepth.load(std::memory_order_relaxed))
+        counters_.maxQueueDepth.store(depth, std::memory_order_relaxed);
+}
+#endif
+
 void Executor::Run()
 {
     if (IsInMainThread())
@@ -68,14 +527,10 @@ void Executor::Run()
 
     _SetThreadExecutorPtr();
 
-    BEGIN_EXCEPTION_PROPAGATION();
-
     while (TaskManager().KeepAlive()) {
         RunOne();
     }
 
-    END_EXCEPTION_PROPAGATION();
-
     _ResetThreadExecutorPtr();
 }
 
@@ -83,6 +538,7 @@ void Executor::_SetThreadExecutorPtr()
 {
     assert(_threadExecutor == nullptr);
     _threadExecutor = this;
+    SlabAllocator::SetThreadAllocator(&slab_);
 
     threadId_ = std::this_thread::get_id();
 }
@@ -90,6 +546,7 @@ void Executor::_SetThreadExecutorPtr()
 void Executor::_ResetThreadExecutorPtr()
 {
     _threadExecutor = nullptr;
+    SlabAllocator::SetThreadAllocator(nullptr);
 
     threadId_ = std::thread::id{};
 }
@@ -99,6 +556,7 @@ void Executor::_SetAsMainThreadExecutor()
     assert(_mainThreadExecutor == nullptr);
     _mainThreadExecutor = this;
     _threadExecutor = this;
+    SlabAllocator::SetThreadAllocator(&slab_);
 
     threadId_ = std::this_thread::get_id();
 }
@@ -107,36 +565,274 @@ void Executor::_ResetMainThreadExecutor()
 {
     _mainThreadExecutor = nullptr;
     _threadExecutor = nullptr;
+    SlabAllocator::SetThreadAllocator(nullptr);
 
     threadId_ = std::thread::id{};
 }
 
+void Executor::_DropPendingTasks()
+{
+    for (auto lane = size_t{ 0 }; lane < task_priority_count_v; lane++) {
+        while (auto slot = Queue(lane).TryPop()) {
+            // destroys the task without running
+            ReleaseTask(slot.value());
+        }
+    }
+}
+
 void Executor::operator()()
 {
     Run();
 }
 
-auto Executor::PendingTask() -> std::optional<Task>
+auto Executor::PendingTask() -> Task*
 {
-    auto task = std::optional<Task>{ std::nullopt };
+    auto firstLane = FirstLane();
+
+    if (picks_ % timer_poll_period_v == 0)
+        PollTimers();
+
+    if (auto* task = PopOwnTask(firstLane))
+        return task;
+
+    if (PollTimers()) {
+        if (auto* task = PopOwnTask(firstLane))
+            return task;
+    }
+
+    // tasks posted by non executor threads go before stealing,
+    // they are stored by value in the injection queue, so they are moved into an own slot
+    if (auto injected = TaskManager().Injection().TryPop()) {
+        auto* slot = Pool().WriteableTask();
+        *slot = std::move(injected.value());
+
+        COUNT_EVENT(injectedTasks);
+        TaskManager().NotifyInjectionSpace();
+
+        return slot;
+    }
+
+    if (auto slot = StealTask(firstLane))
+        return slot.value();
 
-    if (auto ownTask = Queue().TryPop()) {
-        task = std::move(*ownTask.value());
+    return nullptr;
+}
+
+auto Executor::PopOwnTask(size_t firstLane) -> Task*
+{
+    for (auto i = size_t{ 0 }; i < task_priority_count_v; i++) {
+        auto& queue = Queue(lane_at(firstLane, i));
+
+        // the emptiness check is cheaper than a failed pop
+        if (queue.IsEmpty())
+            continue;
+
+        if (auto slot = queue.TryPop()) {
+            COUNT_EVENT(localPops);
+            return slot.value();
+        }
+    }
+
+    return nullptr;
+}
+
+auto Executor::PollTimers() -> bool
+{
+    auto& timers = TaskManager().Timers();
+
+    // no clock reading while there are no timers
+    auto deadline = timers.NextDeadline();
+    if (deadline == TimerWheel::clock_t::time_point::max() || deadline > TimerWheel::clock_t::now())
+        return false;
+
+    auto* timer = timers.Expire(TimerWheel::clock_t::now());
+    if (timer == nullptr)
+        return false;
+
+    while (timer != nullptr) {
+        auto* next = std::exchange(timer->next, nullptr);
+        auto* task = Pool().WriteableTask();
+
+        if (timer->period == 0) {
+            *task = std::move(timer->task);
+            timer->release();
+        } else {
+            // the timer is armed again only after the run, so runs never overlap
+            task->emplace([ref = timer_ref_t{ timer }]() mutable -> void {
+                ref.get()->task();
+
+                auto* timer = ref.take();
+                if (timer->wheel->Rearm(timer))
+                    Executor::ThreadExecutor().TaskManager().WakeTimerWatcher();
+            });
+        }
+
+        Queue(static_cast<size_t>(TaskPriority::High)).Emplace(task);
+        timer = next;
+    }
+
+    NotifyTaskSubmitted();
+
+    return true;
+}
+
+auto Executor::FirstLane() -> size_t
+{
+    auto pick = ++picks_;
+    auto lane = size_t{ 0 };
+
+    for (auto period = lane_rotation_period_v; lane + 1 < task_priority_count_v && pick % period == 0;
+         period *= lane_rotation_period_v) {
+        lane++;
+    }
+
+    return lane;
+}
+
+void Executor::ReleaseTask(Task* task)
+{
+    task->reset();
+
+    // stolen tasks go back to the pool of the executor they were submitted to
+    if (auto* pool = TaskPool::Owner(*task); pool == &Pool()) {
+        pool->Release(task);
     } else {
-        for (auto i = size_t{0}, count = static_cast<size_t>(TaskManager().ExecutorCount()); i < count; i++) {
-            auto& executors = TaskManager().Executors();
-            auto& executor = executors[i];
+        pool->ReleaseRemote(task);
+    }
+}
+
+auto Executor::StealTask(size_t firstLane) -> std::optional<Task*>
+{
+    for (auto i = size_t{ 0 }; i < task_priority_count_v; i++) {
+        if (auto task = StealTaskFromLane(lane_at(firstLane, i))) {
+            failedLocalSteals_ = 0;
+            return task;
+        }
+    }
+
+    lastVictim_ = index_;
+
+    // saturates, so the back-off is not repeated after a long idle period
+    if (failedLocalSteals_ < std::numeric_limits<uint32_t>::max())
+        failedLocalSteals_++;
+
+    return std::nullopt;
+}
+
+auto Executor::StealTaskFromLane(size_t lane) -> std::optional<Task*>
+{
+    if (lastVictim_ != index_) {
+        if (auto task = TryStealFrom(lastVictim_, lane))
+            return task;
+    }
+
+    // other numa nodes are robbed only after a few rounds without work nearby,
+    // so the data of stolen tasks rarely crosses the interconnect
+    auto remote = failedLocalSteals_ >= TaskManager().RemoteStealBackoff();
+
+    for (auto distance = size_t{ 0 }; distance < steal_distance_count_v; distance++) {
+        if (distance == distance_remote_v && !remote)
+            break;
+
+        if (auto task = StealTaskFromVictims(lane, distance))
+            return task;
+    }
+
+    return std::nullopt;
+}
+
+auto Executor::StealTaskFromVictims(size_t lane, size_t distance) -> std::optional<Task*>
+{
+    auto begin = (distance == 0) ? size_t{ 0 } : static_cast<size_t>(victimsEnd_[distance - 1]);
+    auto count = static_cast<size_t>(victimsEnd_[distance]) - begin;
 
-            if (executor.OwnerThreadId() == std::this_thread::get_id())
-                continue;
+    if (count == 0)
+        return std::nullopt;
 
-            if (auto stolenTask = executor.Queue().TrySteal()) {
-                task = std::move(*stolenTask.value());
-                break;
-            }
+    // random starting point, so thieves do not hammer the same victim
+    auto start = static_cast<size_t>(NextRandom() % count);
+
+    for (auto i = size_t{ 0 }; i < count; i++) {
+        auto victim = static_cast<size_t>(victims_[begin + (start + i) % count]);
+
+        if (victim == lastVictim_)
+            continue;
+
+        if (auto task = TryStealFrom(victim, lane)) {
+            lastVictim_ = victim;
+            return task;
         }
     }
 
+    return std::nullopt;
+}
+
+auto Executor::TryStealFrom(size_t victim, size_t lane) -> std::optional<Task*>
+{
+    COUNT_EVENT(stealAttempts);
+
+    auto& executor = TaskManager().Executors()[victim];
+
+    // the rest of the batch keeps its priority in the own lane
+    auto stolenCount = size_t{ 0 };
+    auto task = executor.Queue(lane).TryStealBatch(Queue(lane), &stolenCount);
+
+    if (task) {
+        COUNT_EVENT(steals);
+        COUNT_EVENT(stolenTasks, stolenCount);
+
+#if defined(TASKWEAVER_STATISTICS)
+        if (auto d = distance(placement_, executor.Placement()); d == distance_cache_v) {
+            COUNT_EVENT(localSteals);
+        } else if (d == distance_remote_v) {
+            COUNT_EVENT(remoteSteals);
+        }
+#endif
+
+#if defined(TASKWEAVER_TRACING)
+        if (TaskManager().IsTracing())
+            RecordTrace(TraceEventType::Steal, TraceNow(), static_cast<uint32_t>(victim));
+#endif
+    }
+
     return task;
 }
+
+void Executor::ArrangeVictims()
+{
+    auto& executors = TaskManager().Executors();
+    auto count = static_cast<size_t>(TaskManager().ExecutorCount());
+
+    victims_.clear();
+
+    for (auto d = size_t{ 0 }; d < steal_distance_count_v; d++) {
+        for (auto victim = size_t{ 0 }; victim < count; victim++) {
+            if (victim != index_ && distance(placement_, executors[victim].Placement()) == d)
+                victims_.push_back(static_cast<uint32_t>(victim));
+        }
+
+        victimsEnd_[d] = static_cast<uint32_t>(victims_.size());
+    }
+}
+
+void Executor::PlaceMemory()
+{
+    assert(IsQueueEmpty());
+
+    Pool().Reallocate();
+
+    for (auto& queue : taskQueues_) {
+        queue = std::make_unique<TaskStealingDeque<Task*>>(queue->Capacity());
+    }
+}
+
+auto Executor::NextRandom() -> uint64_t
+{
+    // xorshift64*
+    random_ ^= random_ >> 12;
+    random_ ^= random_ << 25;
+    random_ ^= random_ >> 27;
+
+    return random_ * uint64_t{ 2685821657736338717 };
+}
 }
@@ -6,30 +6,145 @@
 #define TASKWEAVER_EXECUTOR_H
 
 #include "common.h"
+#include "future.h"
+#include "slabAllocator.h"
 #include "taskPool.h"
 #include "taskStealingDeque.h"
+#include "topology.h"
+#include "traceBuffer.h"
+#include <stop_token>
 
 namespace taskweaver {
 class TaskManager;
 
+// own lanes are drained and victims are robbed from the highest priority down,
+// but every few picks an executor starts from a lower lane, so low priority tasks do not starve
+enum class TaskPriority : uint32_t
+{
+    High,
+    Normal,
+    Low,
+};
+
+constexpr auto task_priority_count_v = size_t{ 3 };
+
+// the result of a task which was cancelled by its stop token before it started
+class TaskCancelledError : public std::exception
+{
+public:
+    [[nodiscard]] auto what() const noexcept -> char const* override { return "task cancelled"; }
+};
+
+namespace internal {
+// callables of cancellable tasks may take the stop token to poll it while running
+template<typename F>
+concept StoppableTaskConcept = std::is_invocable_v<F> || std::is_invocable_v<F, std::stop_token>;
+
+template<typename F>
+struct stoppable_task_result
+{
+    using type_t = std::invoke_result_t<F>;
+};
+
+template<typename F>
+    requires std::is_invocable_v<F, std::stop_token>
+struct stoppable_task_result<F>
+{
+    using type_t = std::invoke_result_t<F, std::stop_token>;
+};
+
+template<typename F>
+using stoppable_task_result_t = typename stoppable_task_result<F>::type_t;
+
+// shared by all cancelled tasks, so skipping a task does not allocate
+auto task_cancelled_exception() -> std::exception_ptr const&;
+
+// sleeps while the state holds the parked value, until the deadline if there is one, may wake up spuriously
+void park_wait(std::atomic<uint32_t>& state, uint32_t parked, std::chrono::steady_clock::time_point deadline);
+
+// wakes up one or all the threads sleeping in park_wait on the state
+void park_notify(std::atomic<uint32_t>& state);
+
+void park_notify_all(std::atomic<uint32_t>& state);
+} // internal
+
+// counted only with TASKWEAVER_STATISTICS, zeros otherwise
+struct steal_stats_t
+{
+    uint64_t attempts;     // steal attempts on victims
+    uint64_t steals;       // successful steals
+    uint64_t stolenTasks;  // tasks taken by successful steals
+    uint64_t localSteals;  // steals from victims sharing the l3 cache, the others are on the same numa node
+    uint64_t remoteSteals; // steals from victims on other numa nodes
+};
+
+// scheduler events of an executor, counted only with TASKWEAVER_STATISTICS as well
+struct executor_stats_t
+{
+    uint64_t executedTasks;   // tasks run by the executor, stolen ones included
+    uint64_t localPops;       // tasks taken from own lanes
+    uint64_t injectedTasks;   // tasks taken from the injection queue
+    steal_stats_t steals;
+    uint64_t poolGrowths;     // the task pool was full, so one more chunk of slots was allocated
+    uint64_t queueGrowths;    // a lane was full, so its ring was reallocated twice as big
+    uint64_t injectionStalls; // posts which found the injection queue full and waited, task manager wide only
+    uint64_t maxQueueDepth;   // the most tasks in own lanes seen at submission
+    uint64_t idleRounds;      // spin and yield rounds without work
+    uint64_t parks;           // times the executor went to sleep
+    uint64_t parkedTime;      // nanoseconds of sleep
+};
+
+#if defined(TASKWEAVER_STATISTICS)
+namespace internal {
+// written by the owner thread only, relaxed, a cache line apart from the fields of thieves
+struct alignas(hardware_destructive_interference_size) executor_counters_t
+{
+    std::atomic<uint64_t> executedTasks{ 0 };
+    std::atomic<uint64_t> localPops{ 0 };
+    std::atomic<uint64_t> injectedTasks{ 0 };
+    std::atomic<uint64_t> poolGrowths{ 0 };
+    std::atomic<uint64_t> queueGrowths{ 0 };
+    std::atomic<uint64_t> maxQueueDepth{ 0 };
+    std::atomic<uint64_t> idleRounds{ 0 };
+    std::atomic<uint64_t> parks{ 0 };
+    std::atomic<uint64_t> parkedTime{ 0 };
+    std::atomic<uint64_t> stealAttempts{ 0 };
+    std::atomic<uint64_t> steals{ 0 };
+    std::atomic<uint64_t> stolenTasks{ 0 };
+    std::atomic<uint64_t> localSteals{ 0 };
+    std::atomic<uint64_t> remoteSteals{ 0 };
+
+    // sizes seen at the previous submission, owner thread only
+    size_t poolSize{ 0 };
+    std::array<size_t, task_priority_count_v> queueCapacities{};
+};
+} // internal
+#endif
+
 class Executor
 {
     friend class TaskManager;
+    friend struct internal::future_state_base_t;
+
+    // victims sharing the l3 cache, on the same numa node and on other nodes
+    static constexpr auto steal_distance_count_v = size_t{ 3 };
 
 public:
     Executor() = default;
 
-    Executor(taskweaver::TaskManager& taskManager, size_t taskDequeSize);
+    // taskDequeSize is initial capacity of the executor deque,
+    // placement is the cpu the executor thread runs on, if it is bound
+    Executor(taskweaver::TaskManager& taskManager, size_t index, size_t taskDequeSize, cpu_info_t const& placement);
 
     Executor(Executor const&) = delete;
 
-    Executor(Executor&&) = default;
+    Executor(Executor&&) = delete;
 
     ~Executor() = default;
 
     auto operator=(Executor const&) -> Executor& = delete;
 
-    auto operator=(Executor&&) -> Executor& = default;
+    auto operator=(Executor&&) -> Executor& = delete;
 
     void operator()();
 
@@ -37,13 +152,69 @@ public:
 
     void RunOne();
 
+    // runs one pending task if there is any, never sleeps
+    auto TryRunOne() -> bool;
+
+    // runs pending tasks until the predicate holds, it is checked after every task,
+    // an idle executor sleeps for a millisecond at most between the checks
+    template<typename Predicate>
+    void RunUntil(Predicate&& predicate);
+
+    // runs pending tasks until the deadline, an idle executor sleeps until the deadline at most
+    void RunUntil(std::chrono::steady_clock::time_point deadline);
+
+    template<typename F>
+    auto SubmitTask(F&& f) -> std::enable_if_t<std::is_invocable_v<F>, Future<std::invoke_result_t<F>>>;
+
+    template<typename F>
+    auto SubmitTask(TaskPriority priority, F&& f)
+      -> std::enable_if_t<std::is_invocable_v<F>, Future<std::invoke_result_t<F>>>;
+
+    // the task is skipped if the stop is requested before it starts, the future gets TaskCancelledError then,
+    // a callable which takes std::stop_token receives the token to stop early while running
+    template<internal::StoppableTaskConcept F>
+    auto SubmitTask(std::stop_token token, F&& f) -> Future<internal::stoppable_task_result_t<F>>;
+
+    template<internal::StoppableTaskConcept F>
+    auto SubmitTask(TaskPriority priority, std::stop_token token, F&& f)
+      -> Future<internal::stoppable_task_result_t<F>>;
+
+    // fire and forget, the callable is stored in the task as is, no future and no shared state,
+    // exceptions go to TaskManager::GetLastException if propagation is allowed
     template<typename F>
-    auto SubmitTask(F&& f) -> std::enable_if_t<std::is_invocable_v<F>, std::future<std::invoke_result_t<F>>>;
+    auto Dispatch(F&& f) -> std::enable_if_t<std::is_invocable_v<F>>;
+
+    template<typename F>
+    auto Dispatch(TaskPriority priority, F&& f) -> std::enable_if_t<std::is_invocable_v<F>>;
 
     [[nodiscard]] auto OwnerThreadId() const -> std::thread::id { return threadId_; }
 
+    [[nodiscard]] auto Index() const -> size_t { return index_; }
+
+    // the cpu and the cache, numa node and package groups of the executor
+    [[nodiscard]] auto Placement() const -> cpu_info_t const& { return placement_; }
+
     [[nodiscard]] auto CanSubmit() const -> bool;
 
+    // no own tasks to steal, so the thieves are likely idle
+    [[nodiscard]] auto IsQueueEmpty() const -> bool;
+
+    // can be called in any thread, the counters are read one by one, so the snapshot is not atomic,
+    // all zeros without TASKWEAVER_STATISTICS
+    [[nodiscard]] auto Stats() const -> executor_stats_t;
+
+#if defined(TASKWEAVER_TRACING)
+    // the events recorded while the tracing was on
+    [[nodiscard]] auto Trace() const -> TraceBuffer const& { return trace_; }
+
+    // names the running task in the trace, the tag must live until the trace is written
+    void TagTask(char const* tag) { traceTag_ = tag; }
+#endif
+
+    // slab of the executor, blocks come from it in the executor thread only, other threads get blocks of the global heap,
+    // blocks can be released in any thread
+    [[nodiscard]] auto MemoryResource() -> std::pmr::memory_resource& { return slab_; }
+
     [[nodiscard]] auto TaskManager() const -> taskweaver::TaskManager const& { return *taskManager_; }
 
     [[nodiscard]] auto TaskManager() -> taskweaver::TaskManager& { return *taskManager_; }
@@ -52,14 +223,79 @@ public:
 
     static auto ThreadExecutor() -> Executor&;
 
+    static auto HasThreadExecutor() -> bool;
+
 private:
     [[nodiscard]] auto Pool() const -> TaskPool const& { return taskPool_; }
     [[nodiscard]] auto Pool() -> TaskPool& { return taskPool_; }
 
-    [[nodiscard]] auto Queue() const -> TaskStealingDeque<Task*> const& { return *taskQueue_; }
-    [[nodiscard]] auto Queue() -> TaskStealingDeque<Task*>& { return *taskQueue_; }
+    [[nodiscard]] auto Slab() -> SlabAllocator& { return slab_; }
+
+    [[nodiscard]] auto Queue(size_t lane) const -> TaskStealingDeque<Task*> const& { return *taskQueues_[lane]; }
+    [[nodiscard]] auto Queue(size_t lane) -> TaskStealingDeque<Task*>& { return *taskQueues_[lane]; }
+
+    // the task is executed in its pool slot and released by ReleaseTask, nullptr if there is no one
+    auto PendingTask() -> Task*;
+
+    // the lane the next pick starts from, the other lanes follow from the highest priority down
+    auto FirstLane() -> size_t;
+
+    auto PopOwnTask(size_t firstLane) -> Task*;
 
-    auto PendingTask() -> std::optional<Task>;
+    // moves expired timers into the own high priority lane, returns whether there were some
+    auto PollTimers() -> bool;
+
+    auto StealTask(size_t firstLane) -> std::optional<Task*>;
+
+    auto StealTaskFromLane(size_t lane) -> std::optional<Task*>;
+
+    // destroys the functor in place and returns the slot to its pool
+    void ReleaseTask(Task* task);
+
+    auto StealTaskFromVictims(size_t lane, size_t distance) -> std::optional<Task*>;
+
+    auto TryStealFrom(size_t victim, size_t lane) -> std::optional<Task*>;
+
+    // orders the other executors by distance, so the nearest ones are robbed first
+    void ArrangeVictims();
+
+    // the pool and the deques are allocated again by the executor thread once it is bound to its cpu,
+    // so their memory is on the numa node of the executor, nothing must be submitted to the executor yet
+    void PlaceMemory();
+
+    auto NextRandom() -> uint64_t;
+
+    // the sleep after the spinning is limited by the timeout
+    void Idle(std::chrono::steady_clock::duration timeout = std::chrono::steady_clock::duration::max());
+
+    // awaited state (if any) wakes up the executor when it's ready, the sleep lasts until the deadline at most
+    void Park(internal::future_state_base_t const* awaited = nullptr,
+              std::chrono::steady_clock::time_point until = std::chrono::steady_clock::time_point::max());
+
+    // runs tasks until the state is ready or the deadline passes
+    void HelpUntilReady(internal::future_state_base_t const& state,
+                        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max());
+
+    auto Unpark() -> bool;
+
+    // every executor of the task manager
+    void UnparkAll();
+
+    void NotifyTaskSubmitted();
+
+#if defined(TASKWEAVER_TRACING)
+    void RunTraced(Task& task);
+
+    void RecordTrace(TraceEventType type, int64_t begin, uint32_t arg = 0);
+
+    // nanoseconds since the start of the task manager
+    [[nodiscard]] auto TraceNow() const -> int64_t;
+#endif
+
+#if defined(TASKWEAVER_STATISTICS)
+    // growth of the pool and the lanes and the depth of the lanes after a submission
+    void CountSubmission();
+#endif
 
     void _SetThreadExecutorPtr();
 
@@ -69,39 +305,138 @@ private:
 
     void _ResetMainThreadExecutor();
 
+    void _DropPendingTasks();
+
 private:
     std::thread::id threadId_;
     taskweaver::TaskManager* taskManager_;
+    size_t index_;
+    cpu_info_t placement_;
+    size_t lastVictim_; // the last successful victim, it is likely to have more work
+    std::vector<uint32_t> victims_; // the other executors, the nearest first
+    std::array<uint32_t, steal_distance_count_v> victimsEnd_; // where the victims of each distance end
+    uint32_t failedLocalSteals_; // steal rounds without success on the own numa node
+    uint64_t random_;
+    SlabAllocator slab_; // outlives the pool, since pending tasks may keep blocks from it
     TaskPool taskPool_;
-    std::unique_ptr<TaskStealingDeque<Task*>> taskQueue_;
+    std::array<std::unique_ptr<TaskStealingDeque<Task*>>, task_priority_count_v> taskQueues_; // a lane per priority
+    uint64_t picks_; // pending task lookups, drives the anti-starvation rotation of lanes
+#if defined(TASKWEAVER_TRACING)
+    TraceBuffer trace_;
+    char const* traceTag_; // of the running task
+#endif
+    uint32_t idleRounds_;
+    alignas(hardware_destructive_interference_size) std::atomic<uint32_t> parkState_;
+
+#if defined(TASKWEAVER_STATISTICS)
+    internal::executor_counters_t counters_;
+#endif
 };
 
 template<typename F>
-auto Executor::SubmitTask(F&& f) -> std::enable_if_t<std::is_invocable_v<F>, std::future<std::invoke_result_t<F>>>
+auto Executor::SubmitTask(F&& f) -> std::enable_if_t<std::is_invocable_v<F>, Future<std::invoke_result_t<F>>>
+{
+    return SubmitTask(TaskPriority::Normal, std::forward<F>(f));
+}
+
+template<typename F>
+auto Executor::SubmitTask(TaskPriority priority, F&& f)
+  -> std::enable_if_t<std::is_invocable_v<F>, Future<std::invoke_result_t<F>>>
 {
     assert(CanSubmit());
 
     using result_type_t = std::invoke_result_t<F>;
 
-    auto* task = std::add_pointer_t<Task>{ nullptr };
+    // both pool and deque grow when they are full,
+    // the functor is constructed right in the pool slot
+    auto* task = Pool().WriteableTask();
 
-    // cycle waits a task from pool if there is no one
-    // it must happen hardly ever
-    while ((task = Pool().WriteableTask(), task == nullptr))
-        std::this_thread::yield();
+    auto promise = Promise<result_type_t>{};
+    auto future = promise.get_future();
 
-    auto&& packedTask = std::packaged_task<result_type_t()>{ std::forward<F>(f) };
-    auto future = packedTask.get_future();
+    task->emplace([p = std::move(promise), f = std::forward<F>(f)]() mutable -> void { p.set_result_of(f); });
 
-    *task = Task{ std::move(packedTask) };
+    Queue(static_cast<size_t>(priority)).Emplace(task);
 
-    // cycle waits space in deque if there is no one
-    // it must happen hardly ever as well
-    while (!Queue().TryEmplace(task))
-        std::this_thread::yield();
+    NotifyTaskSubmitted();
 
     return future;
 }
+
+template<internal::StoppableTaskConcept F>
+auto Executor::SubmitTask(std::stop_token token, F&& f) -> Future<internal::stoppable_task_result_t<F>>
+{
+    return SubmitTask(TaskPriority::Normal, std::move(token), std::forward<F>(f));
+}
+
+template<internal::StoppableTaskConcept F>
+auto Executor::SubmitTask(TaskPriority priority, std::stop_token token, F&& f)
+  -> Future<internal::stoppable_task_result_t<F>>
+{
+    assert(CanSubmit());
+
+    using result_type_t = internal::stoppable_task_result_t<F>;
+
+    auto* task = Pool().WriteableTask();
+
+    auto promise = Promise<result_type_t>{};
+    auto future = promise.get_future();
+
+    task->emplace(
+      [p = std::move(promise), token = std::move(token), f = std::forward<F>(f)]() mutable -> void {
+          // checked when the task is taken from the deque, a skipped task just releases its slot
+          if (token.stop_requested()) {
+              p.set_exception(internal::task_cancelled_exception());
+              return;
+          }
+
+          if constexpr (std::is_invocable_v<F, std::stop_token>) {
+              p.set_result_of([&f, &token]() -> result_type_t { return f(token); });
+          } else {
+              p.set_result_of(f);
+          }
+      });
+
+    Queue(static_cast<size_t>(priority)).Emplace(task);
+
+    NotifyTaskSubmitted();
+
+    return future;
+}
+
+template<typename Predicate>
+void Executor::RunUntil(Predicate&& predicate)
+{
+    assert(CanSubmit());
+
+    while (!predicate()) {
+        if (TryRunOne()) {
+            idleRounds_ = 0;
+        } else {
+            Idle(std::chrono::milliseconds{ 1 });
+        }
+    }
+}
+
+template<typename F>
+auto Executor::Dispatch(F&& f) -> std::enable_if_t<std::is_invocable_v<F>>
+{
+    Dispatch(TaskPriority::Normal, std::forward<F>(f));
+}
+
+template<typename F>
+auto Executor::Dispatch(TaskPriority priority, F&& f) -> std::enable_if_t<std::is_invocable_v<F>>
+{
+    assert(CanSubmit());
+
+    auto* task = Pool().WriteableTask();
+
+    task->emplace(std::forward<F>(f));
+
+    Queue(static_cast<size_t>(priority)).Emplace(task);
+
+    NotifyTaskSubmitted();
+}
 }
 
 #endif // TASKWEAVER_EXECUTOR_H
@@ -0,0 +1,115 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#include "future.h"
+#include "executor.h"
+#include "taskManager.h"
+
+namespace taskweaver {
+namespace internal {
+auto future_state_base_t::wait_until(std::chrono::steady_clock::time_point deadline) -> bool
+{
+    if (is_ready())
+        return true;
+
+    if (Executor::HasThreadExecutor()) {
+        auto& executor = Executor::ThreadExecutor();
+
+        // the future may be awaited by several executors, the first one is kept and the others mark the state
+        auto* helper = std::add_pointer_t<Executor>{ nullptr };
+        auto single = helper_.compare_exchange_strong(helper, &executor, std::memory_order_relaxed) ||
+                      helper == &executor;
+
+        status_.fetch_or(single ? future_helping_v : future_helping_v | future_helpers_v, std::memory_order_acq_rel);
+
+        executor.HelpUntilReady(*this, deadline);
+    } else {
+        // the same futex as of parked executors, so the sleep is bounded by the absolute deadline
+        while (!is_ready() && std::chrono::steady_clock::now() < deadline) {
+            auto status = status_.fetch_or(future_waiting_v, std::memory_order_acquire) | future_waiting_v;
+
+            if ((status & future_ready_v) == 0)
+                park_wait(status_, status, deadline);
+        }
+    }
+
+    return is_ready();
+}
+
+void future_state_base_t::wake_waiters()
+{
+    park_notify_all(status_);
+}
+
+void future_state_base_t::wake_helpers(uint32_t status)
+{
+    // pairs with the fence in Executor::Park:
+    // either helper sees the state ready or this thread sees the helper parked
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    auto* helper = helper_.load(std::memory_order_relaxed);
+
+    if ((status & future_helpers_v) != 0) {
+        helper->UnparkAll();
+    } else {
+        helper->Unpark();
+    }
+}
+
+auto current_executor() -> Executor*
+{
+    return Executor::HasThreadExecutor() ? &Executor::ThreadExecutor() : nullptr;
+}
+
+namespace {
+// the task manager may stop right after the check, then its pending tasks are destroyed without running,
+// so the continuation owns the call and makes it in place if it is destroyed before
+struct continuation_call_t
+{
+    continuation_call_t(void (*run)(void* arg), void* arg)
+      : run_{ run }
+      , arg_{ arg }
+    {
+    }
+
+    continuation_call_t(continuation_call_t const&) = delete;
+
+    continuation_call_t(continuation_call_t&& other) noexcept
+      : run_{ std::exchange(other.run_, nullptr) }
+      , arg_{ other.arg_ }
+    {
+    }
+
+    ~continuation_call_t()
+    {
+        if (run_ != nullptr)
+            run_(arg_);
+    }
+
+    auto operator=(continuation_call_t const&) -> continuation_call_t& = delete;
+
+    auto operator=(continuation_call_t&&) -> continuation_call_t& = delete;
+
+    void operator()() { std::exchange(run_, nullptr)(arg_); }
+
+private:
+    void (*run_)(void* arg);
+    void* arg_;
+};
+}
+
+void schedule_continuation(void (*run)(void* arg), void* arg, Executor* fallback)
+{
+    if (auto* executor = current_executor(); executor != nullptr && executor->TaskManager().KeepAlive()) {
+        executor->Dispatch(continuation_call_t{ run, arg });
+    } else if (fallback != nullptr && fallback->TaskManager().KeepAlive()) {
+        // rare path: the future is completed by a foreign thread
+        [[maybe_unused]] auto future = fallback->TaskManager().Post(continuation_call_t{ run, arg });
+    } else {
+        // stopped task manager doesn't run tasks anymore
+        run(arg);
+    }
+}
+} // internal
+}
@@ -0,0 +1,532 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#ifndef TASKWEAVER_FUTURE_H
+#define TASKWEAVER_FUTURE_H
+
+#include "common.h"
+#include "slabAllocator.h"
+#include <cassert>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace taskweaver {
+class Executor;
+
+template<typename T>
+class Future;
+
+template<typename T>
+class Promise;
+
+namespace internal {
+constexpr auto future_pending_v = uint32_t{ 0 };
+constexpr auto future_ready_v = uint32_t{ 1 };
+constexpr auto future_waiting_v = uint32_t{ 2 }; // a thread without executor sleeps on the state
+constexpr auto future_helping_v = uint32_t{ 4 }; // an executor runs other tasks while waiting the state
+constexpr auto future_continuation_v = uint32_t{ 8 }; // a continuation is attached to the state
+constexpr auto future_helpers_v = uint32_t{ 16 }; // more than one executor helps, so all of them are woken up
+
+// intrusive completion callback, owned by the one who attaches it
+struct future_continuation_t
+{
+    void (*invoke)(future_continuation_t* continuation);
+};
+
+// shared state of promise and future,
+// lock free, allocated from the slab of the thread which creates the promise
+struct future_state_base_t
+{
+    explicit future_state_base_t(void (*destroy)(future_state_base_t*))
+      : status_{ future_pending_v }
+      , refs_{ 1 }
+      , exception_{}
+      , helper_{ nullptr }
+      , continuation_{ nullptr }
+      , destroy_{ destroy }
+    {
+    }
+
+    [[nodiscard]] auto is_ready() const -> bool
+    {
+        return (status_.load(std::memory_order_acquire) & future_ready_v) != 0;
+    }
+
+    // executor threads keep running pending tasks while waiting, so
+    // waiting inside a task does not block the whole worker and cannot deadlock the pool,
+    // other threads sleep until the state is ready
+    void wait() { wait_until(std::chrono::steady_clock::time_point::max()); }
+
+    // the same as wait, but gives up at the deadline, returns whether the state is ready
+    auto wait_until(std::chrono::steady_clock::time_point deadline) -> bool;
+
+    void set_exception(std::exception_ptr exception)
+    {
+        exception_ = std::move(exception);
+        complete();
+    }
+
+    // the continuation is invoked once, by the thread which completes the state,
+    // or immediately by the caller if the state is ready already,
+    // only one continuation can be attached
+    void set_continuation(future_continuation_t* continuation)
+    {
+        assert(continuation_ == nullptr);
+
+        continuation_ = continuation;
+        auto status = status_.fetch_or(future_continuation_v, std::memory_order_acq_rel);
+
+        if ((status & future_ready_v) != 0)
+            continuation->invoke(continuation);
+    }
+
+    void rethrow_if_exception() const
+    {
+        if (exception_)
+            std::rethrow_exception(exception_);
+    }
+
+    void add_ref() { refs_.fetch_add(1, std::memory_order_relaxed); }
+
+    void release()
+    {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            destroy_(this);
+    }
+
+protected:
+    void complete()
+    {
+        assert(!is_ready());
+
+        // waiters are woken up only if there are some
+        auto status = status_.exchange(future_ready_v, std::memory_order_acq_rel);
+
+        if ((status & future_waiting_v) != 0)
+            wake_waiters();
+
+        if ((status & future_helping_v) != 0)
+            wake_helpers(status);
+
+        if ((status & future_continuation_v) != 0)
+            continuation_->invoke(continuation_);
+    }
+
+private:
+    void wake_waiters();
+
+    void wake_helpers(uint32_t status);
+
+private:
+    std::atomic<uint32_t> status_;
+    std::atomic<uint32_t> refs_;
+    std::exception_ptr exception_;
+    std::atomic<Executor*> helper_; // the first helping executor, published by future_helping_v bit
+    future_continuation_t* continuation_; // published by future_continuation_v bit
+    void (*destroy_)(future_state_base_t*);
+};
+
+template<typename T>
+struct future_state_t : future_state_base_t
+{
+    future_state_t()
+      : future_state_base_t{ &destroy }
+      , value_{ std::nullopt }
+    {
+    }
+
+    template<typename... Args>
+    void set_value(Args&&... args)
+    {
+        value_.emplace(std::forward<Args>(args)...);
+        complete();
+    }
+
+    auto take_value() -> T { return std::move(value_.value()); }
+
+    static auto create() -> future_state_t*;
+
+    static void destroy(future_state_base_t* state);
+
+private:
+    std::optional<T> value_;
+};
+
+template<>
+struct future_state_t<void> : future_state_base_t
+{
+    future_state_t()
+      : future_state_base_t{ &destroy }
+    {
+    }
+
+    void set_value() { complete(); }
+
+    static auto create() -> future_state_t*;
+
+    static void destroy(future_state_base_t* state);
+};
+
+template<typename State, typename... Args>
+auto create_state(Args&&... args) -> State*
+{
+    if constexpr (alignof(State) <= alignof(std::max_align_t)) {
+        return new (SlabAllocator::ThreadAllocate(sizeof(State))) State{ std::forward<Args>(args)... };
+    } else {
+        return new State{ std::forward<Args>(args)... };
+    }
+}
+
+template<typename State>
+void destroy_state(State* s)
+{
+    if constexpr (alignof(State) <= alignof(std::max_align_t)) {
+        s->~State();
+        SlabAllocator::Deallocate(s);
+    } else {
+        delete s;
+    }
+}
+
+template<typename T>
+auto future_state_t<T>::create() -> future_state_t*
+{
+    return create_state<future_state_t>();
+}
+
+template<typename T>
+void future_state_t<T>::destroy(future_state_base_t* state)
+{
+    destroy_state(static_cast<future_state_t*>(state));
+}
+
+inline auto future_state_t<void>::create() -> future_state_t*
+{
+    return create_state<future_state_t>();
+}
+
+inline void future_state_t<void>::destroy(future_state_base_t* state)
+{
+    destroy_state(static_cast<future_state_t*>(state));
+}
+} // internal
+
+// lightweight analogue of std::future:
+// no locks, shared state is allocated from executor slab,
+// note: futures must not outlive the task manager, since their states live in its executors
+template<typename T>
+class Future
+{
+    static_assert(!std::is_reference_v<T>, "references are not supported as future results");
+
+    template<typename>
+    friend class Promise;
+
+public:
+    using value_type = T;
+
+    Future()
+      : state_{ nullptr }
+    {
+    }
+
+    Future(Future const&) = delete;
+
+    Future(Future&& other) noexcept
+      : state_{ std::exchange(other.state_, nullptr) }
+    {
+    }
+
+    ~Future() { reset(); }
+
+    auto operator=(Future const&) -> Future& = delete;
+
+    auto operator=(Future&& rhs) noexcept -> Future&
+    {
+        if (this != &rhs) {
+            reset();
+            state_ = std::exchange(rhs.state_, nullptr);
+        }
+
+        return *this;
+    }
+
+    [[nodiscard]] auto valid() const -> bool { return state_ != nullptr; }
+
+    [[nodiscard]] auto is_ready() const -> bool
+    {
+        assert(valid());
+        return state_->is_ready();
+    }
+
+    // several threads may wait, executor threads must belong to one task manager
+    void wait() const
+    {
+        assert(valid());
+        state_->wait();
+    }
+
+    template<typename Rep, typename Period>
+    auto wait_for(std::chrono::duration<Rep, Period> const& timeout) const -> std::future_status
+    {
+        return wait_until(std::chrono::steady_clock::now() + timeout);
+    }
+
+    // the same as wait until the deadline, the deadline of other clocks is converted to steady_clock
+    template<typename Clock, typename Duration>
+    auto wait_until(std::chrono::time_point<Clock, Duration> const& deadline) const -> std::future_status
+    {
+        assert(valid());
+
+        if constexpr (std::is_same_v<Clock, std::chrono::steady_clock>) {
+            return state_->wait_until(deadline) ? std::future_status::ready : std::future_status::timeout;
+        } else {
+            // the other clock may be adjusted meanwhile, so its deadline is checked again after a wait
+            for (auto now = Clock::now(); now < deadline; now = Clock::now()) {
+                auto timeout = std::chrono::ceil<std::chrono::steady_clock::duration>(deadline - now);
+
+                if (state_->wait_until(std::chrono::steady_clock::now() + timeout))
+                    return std::future_status::ready;
+            }
+
+            return state_->is_ready() ? std::future_status::ready : std::future_status::timeout;
+        }
+    }
+
+    // waits the result, rethrows an exception if the task has thrown one,
+    // future is not valid anymore after the call
+    auto get() -> T;
+
+    // attaches the function which runs as a task of the executor completing this future,
+    // so the result is consumed while it is hot in that core cache,
+    // the function receives the result (nothing for void futures),
+    // an exception of this future goes to the returned one and the function is not called,
+    // future is not valid anymore after the call
+    template<typename F>
+    auto then(F&& f);
+
+    // low level completion hook, see internal::future_state_base_t::set_continuation,
+    // the continuation must outlive the completion of the future
+    void set_continuation(internal::future_continuation_t& continuation)
+    {
+        assert(valid());
+        state_->set_continuation(&continuation);
+    }
+
+private:
+    explicit Future(internal::future_state_t<T>* state)
+      : state_{ state }
+    {
+    }
+
+    void reset()
+    {
+        if (state_ != nullptr)
+            std::exchange(state_, nullptr)->release();
+    }
+
+private:
+    internal::future_state_t<T>* state_;
+};
+
+template<typename T>
+auto Future<T>::get() -> T
+{
+    assert(valid());
+
+    auto* state = std::exchange(state_, nullptr);
+    state->wait();
+
+    // releases the state on any way out
+    auto release = std::unique_ptr<internal::future_state_base_t, void (*)(internal::future_state_base_t*)>{
+        state, [](internal::future_state_base_t* s) -> void { s->release(); }
+    };
+
+    state->rethrow_if_exception();
+
+    if constexpr (!std::is_void_v<T>) {
+        return state->take_value();
+    }
+}
+
+template<typename T>
+class Promise
+{
+public:
+    Promise()
+      : state_{ internal::future_state_t<T>::create() }
+      , futureRetrieved_{ false }
+    {
+    }
+
+    Promise(Promise const&) = delete;
+
+    Promise(Promise&& other) noexcept
+      : state_{ std::exchange(other.state_, nullptr) }
+      , futureRetrieved_{ other.futureRetrieved_ }
+    {
+    }
+
+    ~Promise() { reset(); }
+
+    auto operator=(Promise const&) -> Promise& = delete;
+
+    auto operator=(Promise&& rhs) noexcept -> Promise&
+    {
+        if (this != &rhs) {
+            reset();
+            state_ = std::exchange(rhs.state_, nullptr);
+            futureRetrieved_ = rhs.futureRetrieved_;
+        }
+
+        return *this;
+    }
+
+    // can be called once
+    auto get_future() -> Future<T>
+    {
+        assert(state_ != nullptr && !futureRetrieved_);
+
+        futureRetrieved_ = true;
+        state_->add_ref();
+
+        return Future<T>{ state_ };
+    }
+
+    template<typename... Args>
+    void set_value(Args&&... args)
+    {
+        assert(state_ != nullptr);
+        state_->set_value(std::forward<Args>(args)...);
+    }
+
+    void set_exception(std::exception_ptr exception)
+    {
+        assert(state_ != nullptr);
+        state_->set_exception(std::move(exception));
+    }
+
+    // invokes the function and stores its result or exception
+    template<typename F>
+    void set_result_of(F&& f)
+    {
+        try {
+            if constexpr (std::is_void_v<T>) {
+                std::forward<F>(f)();
+                set_value();
+            } else {
+                set_value(std::forward<F>(f)());
+            }
+        } catch (...) {
+            set_exception(std::current_exception());
+        }
+    }
+
+private:
+    void reset()
+    {
+        if (state_ == nullptr)
+            return;
+
+        if (!state_->is_ready())
+            state_->set_exception(std::make_exception_ptr(std::future_error{ std::future_errc::broken_promise }));
+
+        std::exchange(state_, nullptr)->release();
+    }
+
+private:
+    internal::future_state_t<T>* state_;
+    bool futureRetrieved_;
+};
+
+namespace internal {
+template<typename T, typename F>
+struct then_result
+{
+    using type_t = std::invoke_result_t<F, T>;
+};
+
+template<typename F>
+struct then_result<void, F>
+{
+    using type_t = std::invoke_result_t<F>;
+};
+
+// executor of the calling thread, nullptr if the thread has no one
+auto current_executor() -> Executor*;
+
+// runs the callback as a task of the executor of the calling thread,
+// threads without executor post it to the fallback executor task manager,
+// it runs in place if there is no fallback or the task manager is stopped
+void schedule_continuation(void (*run)(void* arg), void* arg, Executor* fallback);
+
+template<typename T, typename F>
+struct then_state_t : future_continuation_t
+{
+    using result_t = typename then_result<T, F>::type_t;
+
+    then_state_t(Future<T>&& antecedent, F&& f)
+      : future_continuation_t{ &on_ready }
+      , antecedent_{ std::move(antecedent) }
+      , f_{ std::forward<F>(f) }
+      , promise_{}
+      , fallback_{ current_executor() }
+    {
+    }
+
+    static void on_ready(future_continuation_t* continuation)
+    {
+        auto* state = static_cast<then_state_t*>(continuation);
+        schedule_continuation(&run, state, state->fallback_);
+    }
+
+    static void run(void* arg)
+    {
+        auto* state = static_cast<then_state_t*>(arg);
+
+        state->promise_.set_result_of([state]() -> result_t {
+            if constexpr (std::is_void_v<T>) {
+                state->antecedent_.get();
+                return state->f_();
+            } else {
+                return state->f_(state->antecedent_.get());
+            }
+        });
+
+        destroy_state(state);
+    }
+
+    Future<T> antecedent_;
+    std::decay_t<F> f_;
+    Promise<result_t> promise_;
+    Executor* fallback_;
+};
+} // internal
+
+template<typename T>
+template<typename F>
+auto Future<T>::then(F&& f)
+{
+    assert(valid());
+
+    auto* state = internal::create_state<internal::then_state_t<T, F>>(std::move(*this), std::forward<F>(f));
+    auto future = state->promise_.get_future();
+
+    // the antecedent is owned by the state, so is the continuation
+    state->antecedent_.set_continuation(*state);
+
+    return future;
+}
+
+// waits the future, executor threads run other pending tasks meanwhile
+template<typename T>
+void Wait(Future<T> const& future)
+{
+    future.wait();
+}
+}
+
+#endif // TASKWEAVER_FUTURE_H
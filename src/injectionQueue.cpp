@@ -0,0 +1,86 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#include "injectionQueue.h"
+#include <algorithm>
+#include <bit>
+
+namespace taskweaver {
+InjectionQueue::InjectionQueue(size_t capacity)
+  : mask_{ std::bit_ceil(std::max(capacity, size_t{ 2 })) - 1 }
+  , cells_{ nullptr }
+  , enqueuePosition_{ 0 }
+  , dequeuePosition_{ 0 }
+{
+    cells_ = std::make_unique<cell_t[]>(mask_ + 1);
+
+    for (auto i = size_t{ 0 }; i <= mask_; i++) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+auto InjectionQueue::IsEmpty() const -> bool
+{
+    auto dequeuePosition = dequeuePosition_.load(std::memory_order_acquire);
+    auto enqueuePosition = enqueuePosition_.load(std::memory_order_acquire);
+
+    return static_cast<std::make_signed_t<size_t>>(enqueuePosition - dequeuePosition) <= 0;
+}
+
+auto InjectionQueue::TryPush(Task& task) -> bool
+{
+    auto position = enqueuePosition_.load(std::memory_order_relaxed);
+    auto* cell = std::add_pointer_t<cell_t>{ nullptr };
+
+    while (true) {
+        cell = &cells_[position & mask_];
+
+        auto sequence = cell->sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::make_signed_t<size_t>>(sequence - position);
+
+        if (diff == 0) { // cell is free
+            if (enqueuePosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        } else if (diff < 0) { // full
+            return false;
+        } else { // another producer took the cell
+            position = enqueuePosition_.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->task = std::move(task);
+    cell->sequence.store(position + 1, std::memory_order_release);
+
+    return true;
+}
+
+auto InjectionQueue::TryPop() -> std::optional<Task>
+{
+    auto result = std::optional<Task>{ std::nullopt };
+
+    auto position = dequeuePosition_.load(std::memory_order_relaxed);
+    auto* cell = std::add_pointer_t<cell_t>{ nullptr };
+
+    while (true) {
+        cell = &cells_[position & mask_];
+
+        auto sequence = cell->sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::make_signed_t<size_t>>(sequence - (position + 1));
+
+        if (diff == 0) { // cell has a task
+            if (dequeuePosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        } else if (diff < 0) { // empty
+            return result;
+        } else { // another consumer took the cell
+            position = dequeuePosition_.load(std::memory_order_relaxed);
+        }
+    }
+
+    result.emplace(std::move(cell->task));
+    cell->sequence.store(position + mask_ + 1, std::memory_order_release);
+
+    return result;
+}
+}
@@ -0,0 +1,58 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#ifndef TASKWEAVER_INJECTIONQUEUE_H
+#define TASKWEAVER_INJECTIONQUEUE_H
+
+#include "task.h"
+#include <optional>
+
+namespace taskweaver {
+// bounded MPMC queue for tasks submitted by threads which do not own an executor,
+// lock free, each cell has a sequence number telling whether it is ready for push or pop
+// https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+class InjectionQueue
+{
+    struct cell_t
+    {
+        std::atomic<size_t> sequence;
+        Task task;
+    };
+
+public:
+    InjectionQueue() = default;
+
+    explicit InjectionQueue(size_t capacity);
+
+    InjectionQueue(InjectionQueue const&) = delete;
+
+    InjectionQueue(InjectionQueue&&) = delete;
+
+    ~InjectionQueue() = default;
+
+    auto operator=(InjectionQueue const&) -> InjectionQueue& = delete;
+
+    auto operator=(InjectionQueue&&) -> InjectionQueue& = delete;
+
+    [[nodiscard]] auto Capacity() const -> size_t { return mask_ + 1; }
+
+    [[nodiscard]] auto IsEmpty() const -> bool;
+
+    // can be called in any thread,
+    // task is moved into the queue only if there is a free cell
+    auto TryPush(Task& task) -> bool;
+
+    // can be called in any thread
+    auto TryPop() -> std::optional<Task>;
+
+private:
+    size_t mask_; // capacity is power of two
+    std::unique_ptr<cell_t[]> cells_;
+
+    alignas(hardware_destructive_interference_size) std::atomic<size_t> enqueuePosition_;
+    alignas(hardware_destructive_interference_size) std::atomic<size_t> dequeuePosition_;
+};
+}
+
+#endif // TASKWEAVER_INJECTIONQUEUE_H
@@ -0,0 +1,410 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#ifndef TASKWEAVER_PARALLEL_H
+#define TASKWEAVER_PARALLEL_H
+
+#include "common.h"
+#include "taskManager.h"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <optional>
+
+namespace taskweaver {
+template<typename I>
+concept ParallelIndexConcept = std::integral<I> || std::random_access_iterator<I>;
+
+namespace internal {
+struct no_accumulator_t
+{};
+
+// chunks per executor for the default grain, lazy splitting keeps small chunks cheap
+constexpr auto parallel_chunks_per_executor_v = size_t{ 64 };
+
+// range [0, size) processed with lazy binary splitting:
+// a task processes its range grain by grain and gives away the upper half only when
+// its executor deque is empty, i.e. thieves are likely idle, so the splitting adapts to the load
+// and a busy pool runs the whole loop with a few tasks
+template<typename T, typename Chunk, typename Combine>
+struct parallel_loop_t
+{
+    parallel_loop_t(size_t size, size_t grain, T const& identity, Chunk& chunk, Combine& combine)
+      : chunk_{ chunk }
+      , combine_{ combine }
+      , identity_{ identity }
+      , result_{ identity }
+      , grain_{ grain }
+      , remaining_{ size }
+      , failed_{ false }
+      , exception_{}
+      , mutex_{}
+      , promise_{}
+    {
+    }
+
+    void process(size_t begin, size_t end)
+    {
+        auto& executor = Executor::ThreadExecutor();
+        auto splittable = executor.TaskManager().ExecutorCount() > 1;
+
+        auto done = size_t{ 0 };
+
+        try {
+            auto acc = identity_;
+
+            while (begin < end) {
+                if (splittable && end - begin > grain_ && executor.IsQueueEmpty()) {
+                    auto middle = begin + (end - begin) / 2;
+                    executor.Dispatch([this, middle, end]() -> void { process(middle, end); });
+                    end = middle;
+                    continue;
+                }
+
+                auto last = std::min(begin + grain_, end);
+
+                // a chunk starts from the identity: its accumulator lives in registers,
+                // while the task one is spilled around the dispatch calls
+                acc = combine_(std::move(acc), chunk_(begin, last, identity_));
+
+                done += last - begin;
+                begin = last;
+            }
+
+            if constexpr (!std::is_same_v<T, no_accumulator_t>) {
+                auto lock = std::lock_guard<std::mutex>{ mutex_ };
+                result_ = combine_(std::move(result_), std::move(acc));
+            }
+        } catch (...) {
+            if (!failed_.exchange(true, std::memory_order_relaxed))
+                exception_ = std::current_exception();
+
+            // the rest of the range is abandoned
+            done += end - begin;
+        }
+
+        if (remaining_.fetch_sub(done, std::memory_order_acq_rel) == done) {
+            // the loop may be destroyed as soon as the promise is satisfied
+            auto promise = std::move(promise_);
+            promise.set_value();
+        }
+    }
+
+    // runs the loop with the calling thread participating, waits the rest helping the executor
+    auto run(size_t size) -> T
+    {
+        auto future = promise_.get_future();
+
+        process(0, size);
+        future.wait();
+
+        if (exception_)
+            std::rethrow_exception(exception_);
+
+        return std::move(result_);
+    }
+
+    Chunk& chunk_;
+    Combine& combine_;
+    T identity_;
+    T result_;
+    size_t grain_;
+    std::atomic<size_t> remaining_;
+    std::atomic<bool> failed_;
+    std::exception_ptr exception_;
+    std::mutex mutex_;
+    Promise<void> promise_;
+};
+
+template<typename T, typename Chunk, typename Combine>
+auto parallel_run(size_t size, size_t grain, T const& identity, Chunk&& chunk, Combine&& combine) -> T
+{
+    if (size == 0)
+        return identity;
+
+    // threads without executor run the loop as is
+    if (!Executor::HasThreadExecutor()) {
+        return chunk(size_t{ 0 }, size, identity);
+    }
+
+    if (grain == 0) {
+        auto executors = static_cast<size_t>(Executor::ThreadExecutor().TaskManager().ExecutorCount());
+        grain = std::max(size_t{ 1 }, size / (executors * parallel_chunks_per_executor_v));
+    }
+
+    auto loop = parallel_loop_t<T, std::remove_reference_t<Chunk>, std::remove_reference_t<Combine>>{
+        size, grain, identity, chunk, combine
+    };
+
+    return loop.run(size);
+}
+
+template<ParallelIndexConcept I>
+auto parallel_element(I begin, size_t offset) -> decltype(auto)
+{
+    if constexpr (std::integral<I>) {
+        return static_cast<I>(begin + static_cast<I>(offset));
+    } else {
+        return *(begin + static_cast<std::iter_difference_t<I>>(offset));
+    }
+}
+} // internal
+
+// invokes the body for every index of [begin, end) or for every element of the iterator range,
+// the caller takes part in the loop and returns when it is done,
+// grain is the least number of iterations run by a task without a split, 0 picks it by the range size,
+// the first exception thrown by the body is rethrown, the rest of its task range is skipped
+template<ParallelIndexConcept I, typename Body>
+void parallel_for(I begin, I end, Body&& body, size_t grain = 0)
+{
+    assert(begin <= end);
+
+    auto chunk = [begin, &body](size_t first, size_t last, internal::no_accumulator_t acc) {
+        for (auto i = first; i < last; i++) {
+            body(internal::parallel_element(begin, i));
+        }
+
+        return acc;
+    };
+
+    auto combine = [](internal::no_accumulator_t, internal::no_accumulator_t) -> internal::no_accumulator_t {
+        return internal::no_accumulator_t{};
+    };
+
+    internal::parallel_run(
+      static_cast<size_t>(end - begin), grain, internal::no_accumulator_t{}, chunk, combine);
+}
+
+// reduces the range like std::reduce: op must be associative and commutative,
+// it combines both an accumulator with an element and two partial accumulators
+template<ParallelIndexConcept I, typename T, typename Op>
+auto parallel_reduce(I begin, I end, T identity, Op&& op, size_t grain = 0) -> T
+{
+    assert(begin <= end);
+
+    // the accumulator goes by value, so it stays in registers in the loop
+    auto chunk = [begin, &op](size_t first, size_t last, T acc) -> T {
+        for (auto i = first; i < last; i++) {
+            acc = op(std::move(acc), internal::parallel_element(begin, i));
+        }
+
+        return acc;
+    };
+
+    return internal::parallel_run(static_cast<size_t>(end - begin), grain, identity, chunk, op);
+}
+
+namespace internal {
+// working set of a block: the scan reads it twice and the sort runs std::sort on it,
+// so it should stay in the private cache of the core
+constexpr auto cache_block_bytes_v = size_t{ 64 * 1024 };
+
+template<typename T>
+constexpr auto cache_block_size_v = std::max(size_t{ 1024 }, cache_block_bytes_v / sizeof(T));
+
+// runs both functions, the second one can be stolen,
+// the first exception is rethrown when both are done
+template<typename F1, typename F2>
+void fork_join(F1&& f1, F2&& f2)
+{
+    auto future = TaskManager::SubmitTask(std::forward<F2>(f2));
+
+    try {
+        f1();
+    } catch (...) {
+        future.wait();
+        throw;
+    }
+
+    future.get();
+}
+
+// two-pass blocked scan: block totals in parallel, a sequential scan of the totals,
+// then every block is scanned from its offset in parallel,
+// the exclusive scan writes the accumulator before adding the element
+template<bool Inclusive, typename InputIt, typename OutputIt, typename T, typename Op>
+auto blocked_scan(InputIt first, InputIt last, OutputIt dFirst, std::optional<T> init, Op& op) -> OutputIt
+{
+    auto size = static_cast<size_t>(last - first);
+    auto blockSize = cache_block_size_v<T>;
+    auto blockCount = (size + blockSize - 1) / blockSize;
+
+    auto blockRange = [first, size, blockSize](size_t block) -> std::pair<InputIt, InputIt> {
+        auto begin = block * blockSize;
+        auto end = std::min(begin + blockSize, size);
+
+        return std::pair{ first + static_cast<std::iter_difference_t<InputIt>>(begin),
+                          first + static_cast<std::iter_difference_t<InputIt>>(end) };
+    };
+
+    // the last block total is not needed
+    auto totals = std::vector<std::optional<T>>(blockCount);
+
+    parallel_for(
+      size_t{ 0 },
+      blockCount - 1,
+      [&totals, &blockRange, &op](size_t block) -> void {
+          auto [begin, end] = blockRange(block);
+
+          auto acc = T{ *begin };
+          for (auto it = std::next(begin); it != end; it++) {
+              acc = op(std::move(acc), *it);
+          }
+
+          totals[block] = std::move(acc);
+      },
+      1);
+
+    // offsets[b] = init op totals[0] op ... op totals[b - 1]
+    auto offsets = std::vector<std::optional<T>>(blockCount);
+    offsets[0] = std::move(init);
+
+    for (auto block = size_t{ 1 }; block < blockCount; block++) {
+        offsets[block] = offsets[block - 1] ? op(*offsets[block - 1], *totals[block - 1]) : *totals[block - 1];
+    }
+
+    parallel_for(
+      size_t{ 0 },
+      blockCount,
+      [&offsets, &blockRange, &op, first, dFirst](size_t block) -> void {
+          auto [begin, end] = blockRange(block);
+          auto out = dFirst + (begin - first);
+          if constexpr (Inclusive) {
+              auto acc = offsets[block] ? op(std::move(*offsets[block]), *begin) : T{ *begin };
+              *out++ = acc;
+
+              for (auto it = std::next(begin); it != end; it++, out++) {
+                  acc = op(std::move(acc), *it);
+                  *out = acc;
+              }
+          } else {
+              auto acc = std::move(*offsets[block]);
+
+              for (auto it = begin; it != end; it++, out++) {
+                  // the element is read before the output is written, so the scan can be in place
+                  auto value = T{ *it };
+                  *out = acc;
+                  acc = op(std::move(acc), std::move(value));
+              }
+          }
+      },
+      1);
+
+    return dFirst + static_cast<std::iter_difference_t<OutputIt>>(size);
+}
+
+template<typename It, typename Out, typename Compare>
+void parallel_merge(It first1, It last1, It first2, It last2, Out out, Compare& comp)
+{
+    auto size1 = last1 - first1;
+    auto size2 = last2 - first2;
+
+    if (static_cast<size_t>(size1 + size2) <= cache_block_size_v<std::iter_value_t<It>>) {
+        std::merge(std::make_move_iterator(first1),
+                   std::make_move_iterator(last1),
+                   std::make_move_iterator(first2),
+                   std::make_move_iterator(last2),
+                   out,
+                   comp);
+        return;
+    }
+
+    // splits the longer range in the middle and the other one by its value
+    auto middle1 = first1;
+    auto middle2 = first2;
+
+    if (size1 >= size2) {
+        middle1 = first1 + size1 / 2;
+        middle2 = std::lower_bound(first2, last2, *middle1, comp);
+    } else {
+        middle2 = first2 + size2 / 2;
+        middle1 = std::upper_bound(first1, last1, *middle2, comp);
+    }
+
+    auto middleOut = out + ((middle1 - first1) + (middle2 - first2));
+
+    fork_join([&]() -> void { parallel_merge(first1, middle1, first2, middle2, out, comp); },
+              [&]() -> void { parallel_merge(middle1, last1, middle2, last2, middleOut, comp); });
+}
+
+// merge sort with ping-pong between the range and the buffer:
+// sorts [first, last) into the range itself (inPlace) or into the buffer,
+// the halves are sorted into the other storage, so every level moves the data once
+template<typename RandomIt, typename BufferIt, typename Compare>
+void parallel_merge_sort(RandomIt first, RandomIt last, BufferIt buffer, bool inPlace, Compare& comp)
+{
+    auto size = last - first;
+
+    if (static_cast<size_t>(size) <= cache_block_size_v<std::iter_value_t<RandomIt>>) {
+        std::sort(first, last, comp);
+
+        if (!inPlace)
+            std::move(first, last, buffer);
+
+        return;
+    }
+
+    auto middle = first + size / 2;
+    auto bufferMiddle = buffer + size / 2;
+    auto bufferLast = buffer + size;
+
+    fork_join([&]() -> void { parallel_merge_sort(first, middle, buffer, !inPlace, comp); },
+              [&]() -> void { parallel_merge_sort(middle, last, bufferMiddle, !inPlace, comp); });
+
+    if (inPlace) {
+        parallel_merge(buffer, bufferMiddle, bufferMiddle, bufferLast, first, comp);
+    } else {
+        parallel_merge(first, middle, middle, last, buffer, comp);
+    }
+}
+} // internal
+
+// parallel analogues of the std algorithms for random access ranges,
+// blocks of cache_block_bytes_v are processed by tasks, small ranges and threads without executor
+// run the std algorithms as is
+
+// output range may be the input one
+template<std::random_access_iterator InputIt, std::random_access_iterator OutputIt, typename Op = std::plus<>>
+auto inclusive_scan(InputIt first, InputIt last, OutputIt dFirst, Op op = {}) -> OutputIt
+{
+    using T = std::iter_value_t<InputIt>;
+
+    if (!Executor::HasThreadExecutor() || static_cast<size_t>(last - first) <= internal::cache_block_size_v<T>)
+        return std::inclusive_scan(first, last, dFirst, op);
+
+    return internal::blocked_scan<true>(first, last, dFirst, std::optional<T>{}, op);
+}
+
+// output range may be the input one
+template<std::random_access_iterator InputIt,
+         std::random_access_iterator OutputIt,
+         typename T,
+         typename Op = std::plus<>>
+auto exclusive_scan(InputIt first, InputIt last, OutputIt dFirst, T init, Op op = {}) -> OutputIt
+{
+    if (!Executor::HasThreadExecutor() || static_cast<size_t>(last - first) <= internal::cache_block_size_v<T>)
+        return std::exclusive_scan(first, last, dFirst, std::move(init), op);
+
+    return internal::blocked_scan<false>(first, last, dFirst, std::optional<T>{ std::move(init) }, op);
+}
+
+// merge sort, not stable, elements must be default constructible for the merge buffer
+template<std::random_access_iterator RandomIt, typename Compare = std::less<>>
+void sort(RandomIt first, RandomIt last, Compare comp = {})
+{
+    using value_t = std::iter_value_t<RandomIt>;
+
+    if (!Executor::HasThreadExecutor() || static_cast<size_t>(last - first) <= internal::cache_block_size_v<value_t>) {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    auto buffer = std::vector<value_t>(static_cast<size_t>(last - first));
+    internal::parallel_merge_sort(first, last, buffer.begin(), true, comp);
+}
+}
+
+#endif // TASKWEAVER_PARALLEL_H
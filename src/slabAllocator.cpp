@@ -0,0 +1,190 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#include "slabAllocator.h"
+#include <cassert>
+#include <utility>
+
+#if defined(TASKWEAVER_HUGE_PAGES) && defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace taskweaver {
+namespace {
+thread_local SlabAllocator* _threadAllocator = nullptr;
+
+// stateless, blocks go to the slab of the allocating thread,
+// over aligned blocks go to the global heap
+class thread_resource_t : public std::pmr::memory_resource
+{
+private:
+    auto do_allocate(size_t bytes, size_t alignment) -> void* override
+    {
+        if (alignment > alignof(std::max_align_t))
+            return ::operator new(bytes, std::align_val_t{ alignment });
+
+        return SlabAllocator::ThreadAllocate(bytes);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+    {
+        if (alignment > alignof(std::max_align_t)) {
+            ::operator delete(p, bytes, std::align_val_t{ alignment });
+            return;
+        }
+
+        SlabAllocator::Deallocate(p);
+    }
+
+    [[nodiscard]] auto do_is_equal(std::pmr::memory_resource const& other) const noexcept -> bool override
+    {
+        return this == &other || dynamic_cast<SlabAllocator const*>(&other) != nullptr;
+    }
+};
+}
+
+SlabAllocator::SlabAllocator()
+  : free_{}
+  , current_{ nullptr }
+  , end_{ nullptr }
+  , chunks_{}
+  , remoteFree_{}
+{
+    for (auto&& list : remoteFree_) {
+        list.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+/*static*/ auto SlabAllocator::ThreadAllocator() -> SlabAllocator*
+{
+    return _threadAllocator;
+}
+
+/*static*/ void SlabAllocator::SetThreadAllocator(SlabAllocator* allocator)
+{
+    _threadAllocator = allocator;
+}
+
+/*static*/ auto SlabAllocator::ThreadResource() -> std::pmr::memory_resource*
+{
+    static auto resource = thread_resource_t{};
+    return &resource;
+}
+
+auto SlabAllocator::do_allocate(size_t bytes, size_t alignment) -> void*
+{
+    if (alignment > alignof(std::max_align_t))
+        return ThreadResource()->allocate(bytes, alignment);
+
+    // the slab is carved by its owner thread only, other threads get blocks of the global heap
+    return ThreadAllocator() == this ? Allocate(bytes) : AllocateGlobal(bytes);
+}
+
+void SlabAllocator::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+    ThreadResource()->deallocate(p, bytes, alignment);
+}
+
+// equal resources release the blocks of each other, the header of a block tells where it goes
+auto SlabAllocator::do_is_equal(std::pmr::memory_resource const& other) const noexcept -> bool
+{
+    return this == &other || ThreadResource()->is_equal(other);
+}
+
+/*static*/ auto SlabAllocator::ThreadAllocate(size_t size) -> void*
+{
+    if (auto* allocator = ThreadAllocator())
+        return allocator->Allocate(size);
+
+    return AllocateGlobal(size);
+}
+
+/*static*/ auto SlabAllocator::AllocateGlobal(size_t size) -> void*
+{
+    auto* header = new (::operator new(sizeof(header_t) + size)) header_t{ nullptr, size_classes_v.size() };
+    return header + 1;
+}
+
+auto SlabAllocator::Allocate(size_t size) -> void*
+{
+    assert(ThreadAllocator() == this);
+
+    auto sizeClass = size_t{ 0 };
+    while (sizeClass < size_classes_v.size() && size_classes_v[sizeClass] - sizeof(header_t) < size)
+        sizeClass++;
+
+    if (sizeClass == size_classes_v.size())
+        return AllocateGlobal(size);
+
+    auto* ptr = std::add_pointer_t<std::byte>{ nullptr };
+
+    if (free_[sizeClass] == nullptr)
+        free_[sizeClass] = remoteFree_[sizeClass].exchange(nullptr, std::memory_order_acquire);
+
+    if (auto* block = free_[sizeClass]; block != nullptr) {
+        free_[sizeClass] = block->next;
+        ptr = reinterpret_cast<std::byte*>(block);
+    } else {
+        ptr = Carve(size_classes_v[sizeClass]) + sizeof(header_t);
+    }
+
+    new (ptr - sizeof(header_t)) header_t{ this, sizeClass };
+
+    return ptr;
+}
+
+auto SlabAllocator::Carve(size_t blockSize) -> std::byte*
+{
+    if (current_ == nullptr || static_cast<size_t>(end_ - current_) < blockSize) {
+        auto chunk = std::unique_ptr<std::byte, chunk_deleter_t>{ static_cast<std::byte*>(
+          ::operator new(chunk_size_v, std::align_val_t{ chunk_alignment_v })) };
+
+#if defined(TASKWEAVER_HUGE_PAGES) && defined(__linux__)
+        // only a hint, the chunk stays in regular pages if transparent huge pages are disabled
+        ::madvise(chunk.get(), chunk_size_v, MADV_HUGEPAGE);
+#endif
+
+        chunks_.push_back(std::move(chunk));
+        current_ = chunks_.back().get();
+        end_ = current_ + chunk_size_v;
+    }
+
+    return std::exchange(current_, current_ + blockSize);
+}
+
+void SlabAllocator::chunk_deleter_t::operator()(std::byte* chunk) const
+{
+    ::operator delete(chunk, chunk_size_v, std::align_val_t{ chunk_alignment_v });
+}
+
+/*static*/ void SlabAllocator::Deallocate(void* ptr)
+{
+    if (ptr == nullptr)
+        return;
+
+    auto* header = static_cast<header_t*>(ptr) - 1;
+    auto* owner = header->owner;
+    auto sizeClass = header->sizeClass;
+
+    if (owner == nullptr) {
+        header->~header_t();
+        ::operator delete(header);
+        return;
+    }
+
+    auto* block = new (ptr) block_t{ nullptr };
+
+    if (owner == ThreadAllocator()) {
+        block->next = owner->free_[sizeClass];
+        owner->free_[sizeClass] = block;
+    } else {
+        auto& list = owner->remoteFree_[sizeClass];
+        auto* head = list.load(std::memory_order_relaxed);
+
+        do {
+            block->next = head;
+        } while (!list.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+    }
+}
+}
@@ -0,0 +1,104 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#ifndef TASKWEAVER_SLABALLOCATOR_H
+#define TASKWEAVER_SLABALLOCATOR_H
+
+#include "common.h"
+#include <memory_resource>
+
+namespace taskweaver {
+// per executor allocator of small blocks (future states, task captures and so on),
+// blocks are allocated in the owner thread only, but can be released in any thread:
+// blocks released by other threads go to the lock free lists and the owner takes them back in bulk,
+// as a memory resource it allocates from this slab in the owner thread and from the global heap in the others,
+// ThreadResource allocates from the slab of whichever thread calls it
+class SlabAllocator : public std::pmr::memory_resource
+{
+    struct block_t
+    {
+        block_t* next;
+    };
+
+    // precedes each block, keeps max_align_t alignment of the block
+    struct alignas(std::max_align_t) header_t
+    {
+        SlabAllocator* owner; // nullptr if the block is allocated from the global heap
+        size_t sizeClass;
+    };
+
+public:
+    // sizes of blocks including header
+    static constexpr auto size_classes_v = std::array<size_t, 4>{ 64, 128, 256, 512 };
+
+#if defined(TASKWEAVER_HUGE_PAGES)
+    // one transparent huge page per chunk, aligned so the kernel can back it by a single tlb entry
+    static constexpr auto chunk_size_v = size_t{ 2 * 1024 * 1024 };
+    static constexpr auto chunk_alignment_v = chunk_size_v;
+#else
+    static constexpr auto chunk_size_v = size_t{ 64 * 1024 };
+    static constexpr auto chunk_alignment_v = alignof(std::max_align_t);
+#endif
+
+    SlabAllocator();
+
+    SlabAllocator(SlabAllocator const&) = delete;
+
+    SlabAllocator(SlabAllocator&&) = delete;
+
+    ~SlabAllocator() override = default;
+
+    auto operator=(SlabAllocator const&) -> SlabAllocator& = delete;
+
+    auto operator=(SlabAllocator&&) -> SlabAllocator& = delete;
+
+    // can be called in owner thread only
+    // too large blocks are allocated from the global heap
+    auto Allocate(size_t size) -> void*;
+
+    // can be called in any thread
+    static void Deallocate(void* ptr);
+
+    // allocates from allocator of the calling thread or from the global heap if thread has no one
+    static auto ThreadAllocate(size_t size) -> void*;
+
+    static auto ThreadAllocator() -> SlabAllocator*;
+
+    static void SetThreadAllocator(SlabAllocator* allocator);
+
+    // memory resource which allocates from the allocator of the calling thread, can be used in any thread
+    static auto ThreadResource() -> std::pmr::memory_resource*;
+
+    static constexpr auto MaxBlockSize() -> size_t { return size_classes_v.back() - sizeof(header_t); }
+
+private:
+    struct chunk_deleter_t
+    {
+        void operator()(std::byte* chunk) const;
+    };
+
+    // blocks come from this slab in its owner thread, other threads get blocks of the global heap
+    auto do_allocate(size_t bytes, size_t alignment) -> void* override;
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+
+    // blocks of any slab are released by any slab
+    [[nodiscard]] auto do_is_equal(std::pmr::memory_resource const& other) const noexcept -> bool override;
+
+    static auto AllocateGlobal(size_t size) -> void*;
+
+    auto Carve(size_t blockSize) -> std::byte*;
+
+private:
+    std::array<block_t*, size_classes_v.size()> free_; // owner thread only
+    std::byte* current_;
+    std::byte* end_;
+    std::vector<std::unique_ptr<std::byte, chunk_deleter_t>> chunks_;
+
+    alignas(hardware_destructive_interference_size)
+      std::array<std::atomic<block_t*>, size_classes_v.size()> remoteFree_;
+};
+}
+
+#endif // TASKWEAVER_SLABALLOCATOR_H
@@ -3,69 +3,69 @@
 //
 
 #include "task.h"
+#include <cstring>
 #include <utility>
 
 namespace taskweaver {
 Task::Task()
-  : storage_{}
-  , functor_{ nullptr }
-  , pending_{ false }
+  : nextFree_{ nullptr }
+  , ops_{ nullptr }
+  , pool_{ nullptr }
 {
 }
 
 Task::Task(Task&& task) noexcept
-  : storage_{}
-  , functor_{ nullptr }
-  , pending_{ false }
+  : nextFree_{ nullptr }
+  , ops_{ nullptr }
+  , pool_{ nullptr }
 {
-    assert(task.functor_);
-
-    if (task.storage_ == reinterpret_cast<std::byte*>(task.functor_)) {
-        functor_ = task.functor_->move_to(storage_);
-        std::exchange(task.functor_, nullptr)->~functor_base_t();
-    } else {
-        functor_ = std::exchange(task.functor_, nullptr);
-    }
-
-    pending_.store(functor_ != nullptr, std::memory_order_release);
-    task.pending_.store(false, std::memory_order_release);
+    _relocate_from(task);
 }
 
 auto Task::operator=(Task&& rhs) noexcept -> Task&
 {
-    assert(rhs.functor_);
-
-    if (rhs.storage_ == reinterpret_cast<std::byte*>(rhs.functor_)) {
-        functor_ = rhs.functor_->move_to(storage_);
-        std::exchange(rhs.functor_, nullptr)->~functor_base_t();
-    } else {
-        functor_ = std::exchange(rhs.functor_, nullptr);
+    if (this != &rhs) {
+        _reset();
+        _relocate_from(rhs);
     }
 
-    pending_.store(functor_ != nullptr, std::memory_order_release);
-    rhs.pending_.store(false, std::memory_order_release);
-
     return *this;
 }
 
 void Task::operator()()
 {
-    assert(functor_);
-    functor_->invoke();
+    assert(ops_ != nullptr);
+    ops_->invoke(storage_);
 }
 
-void Task::_reset()
+void Task::reset()
 {
-    if (storage_ == reinterpret_cast<std::byte*>(functor_)) {
-        functor_->~functor_base_t();
-    } else if (functor_ != nullptr) {
-        delete functor_;
+    _reset();
+}
+
+void Task::_relocate_from(Task& task) noexcept
+{
+    assert(task.ops_ != nullptr);
+
+    if (task.ops_->relocate != nullptr) {
+        task.ops_->relocate(storage_, task.storage_);
+    } else {
+        std::memcpy(storage_, task.storage_, storage_size_v);
     }
-    functor_ = nullptr;
+
+    ops_ = std::exchange(task.ops_, nullptr);
+}
+
+void Task::_reset()
+{
+    if (ops_ != nullptr && ops_->destroy != nullptr)
+        ops_->destroy(storage_);
+
+    ops_ = nullptr;
 }
 
 Task::~Task()
 {
     _reset();
 }
-}
\ No newline at end of file
+}
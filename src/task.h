@@ -6,53 +6,45 @@
 #define TASKWEAVER_TASK_H
 
 #include "common.h"
+#include "slabAllocator.h"
 #include <cassert>
 
 namespace taskweaver {
 class Task;
+class TaskPool;
 
 template<typename T>
 concept TaskFunctorConcept = !
 std::is_same_v<std::decay_t<T>, Task>;
 
+// size of the task slot, it is a cache line by default,
+// captures which do not fit go to the slab of the executor which creates the task
+#if !defined(TASKWEAVER_TASK_SIZE)
+#define TASKWEAVER_TASK_SIZE 64
+#endif
+
 class alignas(hardware_destructive_interference_size) Task
 {
-    static constexpr size_t storage_align_v = alignof(void (*)());
-    static constexpr size_t storage_size_v = 64;
+    friend class TaskPool;
 
-    struct functor_base_t
+    // type erasure without vtable: one pointer to the static table of the functor type
+    struct ops_t
     {
-        functor_base_t() = default;
-
-        virtual ~functor_base_t() = default;
-
-        virtual void invoke() = 0;
-
-        virtual auto move_to(std::byte (&storage)[storage_size_v]) -> functor_base_t* = 0;
+        void (*invoke)(void* storage);
+        void (*relocate)(void* dst, void* src) noexcept; // moves to dst and destroys src, nullptr for memcpy
+        void (*destroy)(void* storage) noexcept;         // nullptr for trivially destructible
     };
 
-    template<typename F>
-    struct functor_t : functor_base_t
-    {
-        explicit functor_t(F const& f)
-          : f_(f)
-        {
-        }
-
-        explicit functor_t(F&& f)
-          : f_(std::move(f))
-        {
-        }
-
-        void invoke() override { f_(); }
-
-        auto move_to(std::byte (&storage)[storage_size_v]) -> functor_base_t* override;
+public:
+    static constexpr size_t size_v = TASKWEAVER_TASK_SIZE;
+    static constexpr size_t storage_align_v = alignof(std::max_align_t);
+    static constexpr size_t storage_size_v = size_v - sizeof(ops_t const*) - sizeof(TaskPool*);
 
-    private:
-        F f_;
-    };
+    // whether the functor is stored in the task itself or in the slab
+    template<typename F>
+    static constexpr bool is_inline_v = sizeof(F) <= storage_size_v && alignof(F) <= storage_align_v &&
+                                        std::is_nothrow_move_constructible_v<F>;
 
-public:
     Task();
 
     template<TaskFunctorConcept F>
@@ -66,55 +58,116 @@ public:
 
     auto operator=(Task&& rhs) noexcept -> Task&;
 
+    // constructs the functor in place, e.g. right in the pool slot
+    template<TaskFunctorConcept F>
+    void emplace(F&& f);
+
     void operator()();
 
-    [[nodiscard]] auto pending() const -> bool { return pending_.load(std::memory_order_acquire); }
+    [[nodiscard]] auto pending() const -> bool { return ops_ != nullptr; }
+
+    // destroys the functor in place, so the slot can be reused without moving the task out
+    void reset();
 
     ~Task();
 
 private:
+    template<typename F>
+    struct inline_ops_t
+    {
+        static void invoke(void* storage) { (*static_cast<F*>(storage))(); }
+
+        static void relocate(void* dst, void* src) noexcept
+        {
+            new (dst) F{ std::move(*static_cast<F*>(src)) };
+            static_cast<F*>(src)->~F();
+        }
+
+        static void destroy(void* storage) noexcept { static_cast<F*>(storage)->~F(); }
+
+        static constexpr auto ops_v = ops_t{ &invoke,
+                                             std::is_trivially_copyable_v<F> ? nullptr : &relocate,
+                                             std::is_trivially_destructible_v<F> ? nullptr : &destroy };
+    };
+
+    // the storage keeps the pointer to the functor, so relocation is memcpy
+    template<typename F>
+    struct boxed_ops_t
+    {
+        static constexpr bool is_slab_v = alignof(F) <= alignof(std::max_align_t);
+
+        static void invoke(void* storage) { (**static_cast<F**>(storage))(); }
+
+        static void destroy(void* storage) noexcept
+        {
+            auto* f = *static_cast<F**>(storage);
+
+            if constexpr (is_slab_v) {
+                f->~F();
+                SlabAllocator::Deallocate(f);
+            } else {
+                delete f;
+            }
+        }
+
+        static constexpr auto ops_v = ops_t{ &invoke, nullptr, &destroy };
+    };
+
     void _reset();
 
+    void _relocate_from(Task& task) noexcept;
+
     auto storage() -> void* { return storage_; }
 
 private:
-    alignas(storage_align_v) std::byte storage_[storage_size_v]; // for small functor optimization (sfo)
-    functor_base_t* functor_;
-    std::atomic<bool> pending_;
-};
-
-template<typename F>
-auto Task::functor_t<F>::move_to(std::byte (&storage)[storage_size_v]) -> functor_base_t*
-{
-    auto* r = std::add_pointer_t<functor_base_t>{ nullptr };
+    union
+    {
+        alignas(storage_align_v) std::byte storage_[storage_size_v]; // for small functor optimization (sfo)
+        Task* nextFree_;                                             // free pool slot has no functor
+    };
 
-    void* sdata = std::data(storage);
-    size_t ssize = std::size(storage);
+    ops_t const* ops_;
+    TaskPool* pool_; // pool slot bookkeeping, it is not moved along with the functor
+};
 
-    if (auto* p = std::align(alignof(functor_t<F>), sizeof(functor_t<F>), sdata, ssize); p == std::data(storage)) {
-        r = new (p) functor_t<F>{ std::move(f_) };
-    }
+static_assert(sizeof(Task) == Task::size_v, "task size must be a multiple of the cache line size");
 
-    assert(r != nullptr);
-    return r;
+template<TaskFunctorConcept F>
+Task::Task(F&& f)
+  : nextFree_{ nullptr }
+  , ops_{ nullptr }
+  , pool_{ nullptr }
+{
+    emplace(std::forward<F>(f));
 }
 
 template<TaskFunctorConcept F>
-Task::Task(F&& f)
-  : storage_{}
-  , functor_{ nullptr }
-  , pending_{ false }
+void Task::emplace(F&& f)
 {
-    void* storage = std::data(storage_);
-    auto size = std::size(storage_);
+    using functor_t = std::decay_t<F>;
+
+    _reset();
 
-    if (auto* p = std::align(alignof(functor_t<F>), sizeof(functor_t<F>), storage, size); p == std::data(storage_)) {
-        // in case functor is small enough and functor alignment matches with sfo buffer alignment
-        functor_ = new (p) functor_t<F>{ std::forward<F>(f) };
+    if constexpr (is_inline_v<functor_t>) {
+        new (storage()) functor_t{ std::forward<F>(f) };
+        ops_ = &inline_ops_t<functor_t>::ops_v;
     } else {
-        functor_ = new functor_t<F>{ std::forward<F>(f) };
+        auto* p = std::add_pointer_t<functor_t>{ nullptr };
+
+        if constexpr (boxed_ops_t<functor_t>::is_slab_v) {
+            // the block goes back to the slab if the functor constructor throws
+            auto block = std::unique_ptr<void, void (*)(void*)>{ SlabAllocator::ThreadAllocate(sizeof(functor_t)),
+                                                                 &SlabAllocator::Deallocate };
+
+            p = new (block.get()) functor_t{ std::forward<F>(f) };
+            block.release();
+        } else {
+            p = new functor_t{ std::forward<F>(f) };
+        }
+
+        new (storage()) functor_t*{ p };
+        ops_ = &boxed_ops_t<functor_t>::ops_v;
     }
-    pending_.store(functor_ != nullptr, std::memory_order_relaxed);
 }
 }
 
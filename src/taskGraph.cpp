@@ -0,0 +1,158 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#include "taskGraph.h"
+
+namespace taskweaver {
+TaskGraph::TaskGraph()
+  : nodes_{}
+  , edges_{}
+  , successors_{}
+  , roots_{}
+  , pending_{ nullptr }
+  , prepared_{ false }
+  , remaining_{ 0 }
+  , failed_{ false }
+  , exception_{}
+  , promise_{ std::nullopt }
+{
+}
+
+void TaskGraph::Precede(node_id_t before, node_id_t after)
+{
+    assert(before < nodes_.size() && after < nodes_.size() && before != after);
+    assert(remaining_.load(std::memory_order_relaxed) == 0);
+
+    edges_.emplace_back(before, after);
+    prepared_ = false;
+}
+
+auto TaskGraph::Run() -> Future<void>
+{
+    assert(Executor::HasThreadExecutor());
+    assert(remaining_.load(std::memory_order_relaxed) == 0);
+
+    if (!prepared_)
+        Prepare();
+
+    if (nodes_.empty()) {
+        auto promise = Promise<void>{};
+        promise.set_value();
+        return promise.get_future();
+    }
+
+    promise_.emplace();
+    auto future = promise_->get_future();
+
+    for (auto i = size_t{ 0 }; i < nodes_.size(); i++) {
+        pending_[i].store(nodes_[i].predecessors, std::memory_order_relaxed);
+    }
+
+    failed_.store(false, std::memory_order_relaxed);
+    exception_ = nullptr;
+
+    // released by the schedule of the roots
+    remaining_.store(nodes_.size(), std::memory_order_release);
+
+    for (auto root : roots_) {
+        Schedule(root);
+    }
+
+    return future;
+}
+
+void TaskGraph::Prepare()
+{
+    // successor lists in a row, grouped by the predecessor (counting sort of the edges)
+    for (auto& node : nodes_) {
+        node.predecessors = 0;
+        node.successorCount = 0;
+    }
+
+    for (auto [before, after] : edges_) {
+        nodes_[before].successorCount++;
+        nodes_[after].predecessors++;
+    }
+
+    auto offset = size_t{ 0 };
+    for (auto& node : nodes_) {
+        node.firstSuccessor = offset;
+        offset += node.successorCount;
+        node.successorCount = 0;
+    }
+
+    successors_.resize(edges_.size());
+    for (auto [before, after] : edges_) {
+        auto& node = nodes_[before];
+        successors_[node.firstSuccessor + node.successorCount++] = after;
+    }
+
+    roots_.clear();
+    for (auto i = size_t{ 0 }; i < nodes_.size(); i++) {
+        if (nodes_[i].predecessors == 0)
+            roots_.push_back(i);
+    }
+
+    // a graph with nodes but without roots has a cycle
+    assert(nodes_.empty() || !roots_.empty());
+
+    pending_ = std::make_unique<std::atomic<uint32_t>[]>(nodes_.size());
+    prepared_ = true;
+}
+
+void TaskGraph::Schedule(node_id_t node)
+{
+    Executor::ThreadExecutor().Dispatch([this, node]() -> void { RunNode(node); });
+}
+
+void TaskGraph::RunNode(node_id_t id)
+{
+    while (true) {
+        auto& node = nodes_[id];
+
+        try {
+            node.task();
+        } catch (...) {
+            if (!failed_.exchange(true, std::memory_order_relaxed))
+                exception_ = std::current_exception();
+        }
+
+        // the last ready successor runs in place, the others go to the deque for thieves
+        auto next = std::optional<node_id_t>{};
+
+        for (auto i = size_t{ 0 }; i < node.successorCount; i++) {
+            auto successor = successors_[node.firstSuccessor + i];
+
+            if (pending_[successor].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                if (next)
+                    Schedule(next.value());
+                next = successor;
+            }
+        }
+
+        if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            Finish();
+            return;
+        }
+
+        if (!next)
+            return;
+
+        id = next.value();
+    }
+}
+
+void TaskGraph::Finish()
+{
+    // the graph may be destroyed as soon as the future is ready
+    auto promise = std::move(promise_.value());
+    promise_.reset();
+
+    if (exception_) {
+        promise.set_exception(std::exchange(exception_, nullptr));
+    } else {
+        promise.set_value();
+    }
+}
+}
@@ -0,0 +1,105 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#ifndef TASKWEAVER_TASKGRAPH_H
+#define TASKWEAVER_TASKGRAPH_H
+
+#include "common.h"
+#include "taskManager.h"
+
+namespace taskweaver {
+// reusable DAG of tasks: nodes and edges are declared up front,
+// a finished node decrements the predecessor counters of its successors
+// and pushes the ready ones into the deque of the executor it runs on,
+// the structure is built once and re-run without allocations
+class TaskGraph
+{
+public:
+    using node_id_t = size_t;
+
+    TaskGraph();
+
+    // running nodes refer to the graph
+    TaskGraph(TaskGraph const&) = delete;
+
+    TaskGraph(TaskGraph&&) = delete;
+
+    ~TaskGraph() = default;
+
+    auto operator=(TaskGraph const&) -> TaskGraph& = delete;
+
+    auto operator=(TaskGraph&&) -> TaskGraph& = delete;
+
+    // the callable is kept in the node and invoked once per run, large ones are kept on the global heap
+    template<typename F>
+    auto Emplace(F&& f) -> std::enable_if_t<std::is_invocable_v<F>, node_id_t>;
+
+    // the node after starts only when the node before is finished, cycles are not allowed
+    void Precede(node_id_t before, node_id_t after);
+
+    // can be called in executor threads only,
+    // the graph must not be changed or run again until the returned future is ready,
+    // the first exception thrown by a node goes to the future, the rest of the graph still runs
+    auto Run() -> Future<void>;
+
+    [[nodiscard]] auto Size() const -> size_t { return nodes_.size(); }
+
+private:
+    struct node_t
+    {
+        Task task;
+        uint32_t predecessors;
+        size_t firstSuccessor; // successors are stored in successors_ in a row
+        size_t successorCount;
+    };
+
+    // builds the successor lists and counters after the graph is changed
+    void Prepare();
+
+    void Schedule(node_id_t node);
+
+    void RunNode(node_id_t node);
+
+    void Finish();
+
+private:
+    std::vector<node_t> nodes_;
+    std::vector<std::pair<node_id_t, node_id_t>> edges_;
+    std::vector<node_id_t> successors_;
+    std::vector<node_id_t> roots_;
+    std::unique_ptr<std::atomic<uint32_t>[]> pending_; // predecessors left per node in the current run
+    bool prepared_;
+
+    alignas(hardware_destructive_interference_size) std::atomic<size_t> remaining_;
+    std::atomic<bool> failed_;
+    std::exception_ptr exception_;
+    std::optional<Promise<void>> promise_; // only while running, so an idle graph may outlive task manager
+};
+
+template<typename F>
+auto TaskGraph::Emplace(F&& f) -> std::enable_if_t<std::is_invocable_v<F>, node_id_t>
+{
+    assert(remaining_.load(std::memory_order_relaxed) == 0);
+
+    using functor_t = std::decay_t<F>;
+
+    // a large callable would be boxed in the slab of the building executor, so it goes to the global heap instead,
+    // the graph may outlive the task manager
+    if constexpr (Task::is_inline_v<functor_t>) {
+        nodes_.push_back(node_t{ Task{ std::forward<F>(f) }, 0, 0, 0 });
+    } else {
+        nodes_.push_back(node_t{ Task{ [boxed = std::make_unique<functor_t>(std::forward<F>(f))]() -> void {
+                                     (*boxed)();
+                                 } },
+                                 0,
+                                 0,
+                                 0 });
+    }
+    prepared_ = false;
+
+    return nodes_.size() - 1;
+}
+}
+
+#endif // TASKWEAVER_TASKGRAPH_H
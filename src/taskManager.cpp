@@ -3,24 +3,66 @@
 //
 
 #include "taskManager.h"
+#include <ostream>
 
 namespace taskweaver {
+namespace {
+// a producer facing the full injection queue yields that many times before it sleeps
+constexpr auto injection_yield_rounds_v = uint32_t{ 64 };
+}
+
 TaskManager::TaskManager(size_t taskQueueSize /* = 256*/,
-                         size_t threadPoolSize /* = std::max(std::thread::hardware_concurrency(), 1u)*/)
+                         size_t threadPoolSize /* = std::max(std::thread::hardware_concurrency(), 1u)*/,
+                         size_t injectionQueueSize /* = 1024*/)
+  : TaskManager{ task_manager_options_t{ taskQueueSize, injectionQueueSize, threadPoolSize } }
+{
+}
+
+TaskManager::TaskManager(task_manager_options_t const& options)
   : threadPool_{}
-  , executorCount_{ threadPoolSize + 1 } // plus main thread
+  , topology_{ Topology::Detect(options.cpuset) }
+  , mainThreadWorker_{ options.mainThreadWorker }
+  , pinThreads_{ options.pinThreads }
+  , restricted_{ !options.cpuset.empty() }
+  , mainThreadAffinity_{}
+  , remoteStealBackoff_{ options.remoteStealBackoff }
+  , placingThreads_{ 0 }
+#if defined(TASKWEAVER_TRACING)
+  , traceBufferSize_{ options.traceBufferSize }
+  , traceEpoch_{ std::chrono::steady_clock::now() }
+  , tracing_{ false }
+#endif
+  // the main thread is either one of the workers or an extra executor
+  , executorCount_{ options.mainThreadWorker ? std::max(options.threadPoolSize, size_t{ 1 })
+                                             : options.threadPoolSize + 1 }
   , executors_{ make_unique_for_overwrite<Executor[]>(executorCount_) }
+  , injectionQueue_{ options.injectionQueueSize }
+  , injectionSpace_{ 0 }
+  , injectionWaiters_{ 0 }
+#if defined(TASKWEAVER_STATISTICS)
+  , injectionStalls_{ 0 }
+#endif
+  , timers_{}
+  , timerWatcher_{ nullptr }
   , alive_{ true }
+  , parkedCount_{ 0 }
+  , notifyCursor_{ 0 }
 #if defined(ALLOW_THREAD_EXCEPTIONS_PROPAGATION)
   , exPropagationMutex_{}
   , exceptions_{}
 #endif
 {
     for (auto i = size_t{ 0 }; i < executorCount_; i++) {
-        new (&executors_[i]) Executor{ *this, taskQueueSize };
+        // the main thread which is not a worker shares the cpu of the first worker
+        auto slot = (mainThreadWorker_ || i == 0) ? i : i - 1;
+        new (&executors_[i]) Executor{ *this, i, options.taskQueueSize, topology_.Placement(slot) };
     }
 
-    threadPool_.reserve(threadPoolSize);
+    for (auto i = size_t{ 0 }; i < executorCount_; i++) {
+        executors_[i].ArrangeVictims();
+    }
+
+    threadPool_.reserve(executorCount_ - 1);
 
     executors_[0]._SetAsMainThreadExecutor();
 }
@@ -29,6 +71,17 @@ TaskManager::~TaskManager()
 {
     Stop();
 
+    // pending tasks keep blocks of executor slabs,
+    // so they are destroyed while all the executors are alive
+    for (auto i = size_t{ 0 }; i < executorCount_; i++) {
+        executors_[i]._DropPendingTasks();
+    }
+
+    while (injectionQueue_.TryPop()) {
+    }
+
+    timers_.Clear();
+
     executors_[0]._ResetMainThreadExecutor();
 }
 
@@ -36,23 +89,270 @@ void TaskManager::Start()
 {
     assert(Executor::IsInMainThread());
 
+    placingThreads_.store(pinThreads_ ? static_cast<uint32_t>(executorCount_ - 1) : 0);
+
     for (auto i = size_t{ 0 }; i < executorCount_; i++) {
+        auto affinity = Affinity(i);
+
         if (executors_[i].CanSubmit()) {
+            if (!affinity.empty()) {
+                mainThreadAffinity_ = Topology::ThreadAffinity();
+                Topology::PinThread(affinity);
+            }
+
             executors_[i]();
         } else {
-            threadPool_.emplace_back([](Executor& executor) -> void { executor(); }, std::ref(executors_[i]));
+            threadPool_.emplace_back(
+              [this](Executor& executor, std::vector<uint32_t> const& affinity) -> void {
+                  // a failed binding leaves the thread floating, it is not worth failing the start
+                  if (!affinity.empty())
+                      Topology::PinThread(affinity);
+
+                  // first touch by the bound thread, the others must not steal from the executor meanwhile
+                  if (pinThreads_) {
+                      executor.PlaceMemory();
+                      WaitPlacingThreads(placingThreads_.fetch_sub(1) - 1);
+                  }
+
+                  executor();
+              },
+              std::ref(executors_[i]),
+              std::move(affinity));
         }
     }
+
+    WaitPlacingThreads(placingThreads_.load());
+}
+
+void TaskManager::WaitPlacingThreads(uint32_t placing)
+{
+    if (placing == 0) {
+        placingThreads_.notify_all();
+        return;
+    }
+
+    while (placing != 0) {
+        placingThreads_.wait(placing);
+        placing = placingThreads_.load();
+    }
 }
 
 void TaskManager::Stop()
 {
     alive_.store(false);
 
+    NotifyAll();
+    NotifyInjectionSpace();
+
     for (auto&& thread : threadPool_) {
         if (thread.joinable())
             thread.join();
     }
+
+    if (!mainThreadAffinity_.empty())
+        Topology::PinThread(std::exchange(mainThreadAffinity_, {}));
+}
+
+auto TaskManager::Affinity(size_t executor) const -> std::vector<uint32_t>
+{
+    // the main thread is the application one, it is bound only when it works for the pool
+    if (executor == 0 && !mainThreadWorker_)
+        return {};
+
+    if (pinThreads_)
+        return { executors_[executor].Placement().cpu };
+
+    if (!restricted_)
+        return {};
+
+    auto cpus = std::vector<uint32_t>{};
+    for (auto const& cpu : topology_.Cpus()) {
+        cpus.push_back(cpu.cpu);
+    }
+
+    return cpus;
+}
+
+auto TaskManager::RunOne() -> bool
+{
+    return MainExecutor().TryRunOne();
+}
+
+void TaskManager::NotifyOne()
+{
+    // pairs with the fence in Executor::Park
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (parkedCount_.load(std::memory_order_relaxed) == 0)
+        return;
+
+    // rotates the starting point, so wake ups are spread over executors
+    auto start = static_cast<size_t>(notifyCursor_.fetch_add(1, std::memory_order_relaxed));
+
+    for (auto i = size_t{ 0 }; i < executorCount_; i++) {
+        if (executors_[(start + i) % executorCount_].Unpark())
+            break;
+    }
+}
+
+void TaskManager::Inject(Task& task)
+{
+    // a stopped task manager takes nothing from the queue anymore
+    if (!KeepAlive()) {
+        task();
+        return;
+    }
+
+    if (!injectionQueue_.TryPush(task)) {
+#if defined(TASKWEAVER_STATISTICS)
+        injectionStalls_.fetch_add(1, std::memory_order_relaxed);
+#endif
+
+        // producers are faster than all the executors together, so a full queue is usual under a flood:
+        // the producer yields for a while, then sleeps until an executor takes a task,
+        // the sleep is bounded, so a wake up missed between the push and the sleep costs a tick at most
+        for (auto round = uint32_t{ 0 }; !injectionQueue_.TryPush(task); round++) {
+            if (!KeepAlive()) {
+                task();
+                return;
+            }
+
+            NotifyOne();
+
+            if (round < injection_yield_rounds_v) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            injectionWaiters_.fetch_add(1, std::memory_order_seq_cst);
+            auto space = injectionSpace_.load(std::memory_order_acquire);
+
+            if (!injectionQueue_.TryPush(task)) {
+                internal::park_wait(injectionSpace_, space, std::chrono::steady_clock::now() + TimerWheel::tick_v);
+            } else {
+                injectionWaiters_.fetch_sub(1, std::memory_order_relaxed);
+                break;
+            }
+
+            injectionWaiters_.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    NotifyOne();
+}
+
+void TaskManager::NotifyInjectionSpace()
+{
+    // a relaxed load per injected task, a waiter missed here wakes up by its timeout
+    if (injectionWaiters_.load(std::memory_order_relaxed) == 0)
+        return;
+
+    injectionSpace_.fetch_add(1, std::memory_order_release);
+    internal::park_notify_all(injectionSpace_);
+}
+
+void TaskManager::NotifyAll()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    for (auto i = size_t{ 0 }; i < executorCount_; i++) {
+        executors_[i].Unpark();
+    }
+}
+
+void TaskManager::Schedule(internal::timer_node_t* timer, TimerWheel::clock_t::time_point deadline)
+{
+    if (timers_.Insert(timer, deadline))
+        WakeTimerWatcher();
+}
+
+void TaskManager::WakeTimerWatcher()
+{
+    // pairs with the fence in Executor::Park:
+    // either the watcher sees the new deadline or it is woken up here
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (auto* watcher = timerWatcher_.load(std::memory_order_relaxed); watcher != nullptr && watcher->Unpark())
+        return;
+
+    // no executor sleeps until a deadline, any parked one becomes the watcher
+    NotifyOne();
+}
+
+auto TaskManager::Stats() const -> executor_stats_t
+{
+    auto stats = executor_stats_t{};
+
+    for (auto i = size_t{ 0 }; i < executorCount_; i++) {
+        auto executorStats = executors_[i].Stats();
+
+        stats.steals.attempts += executorStats.steals.attempts;
+        stats.steals.steals += executorStats.steals.steals;
+        stats.steals.stolenTasks += executorStats.steals.stolenTasks;
+        stats.steals.localSteals += executorStats.steals.localSteals;
+        stats.steals.remoteSteals += executorStats.steals.remoteSteals;
+
+        stats.executedTasks += executorStats.executedTasks;
+        stats.localPops += executorStats.localPops;
+        stats.injectedTasks += executorStats.injectedTasks;
+        stats.poolGrowths += executorStats.poolGrowths;
+        stats.queueGrowths += executorStats.queueGrowths;
+        stats.maxQueueDepth = std::max(stats.maxQueueDepth, executorStats.maxQueueDepth);
+        stats.idleRounds += executorStats.idleRounds;
+        stats.parks += executorStats.parks;
+        stats.parkedTime += executorStats.parkedTime;
+    }
+
+#if defined(TASKWEAVER_STATISTICS)
+    stats.injectionStalls = injectionStalls_.load(std::memory_order_relaxed);
+#endif
+
+    return stats;
+}
+
+void TaskManager::StartTracing()
+{
+#if defined(TASKWEAVER_TRACING)
+    tracing_.store(true, std::memory_order_relaxed);
+#endif
+}
+
+void TaskManager::StopTracing()
+{
+#if defined(TASKWEAVER_TRACING)
+    tracing_.store(false, std::memory_order_relaxed);
+#endif
+}
+
+void TaskManager::WriteTrace(std::ostream& out) const
+{
+    auto buffers = std::vector<TraceBuffer const*>(executorCount_, nullptr);
+
+#if defined(TASKWEAVER_TRACING)
+    for (auto i = size_t{ 0 }; i < executorCount_; i++) {
+        buffers[i] = &executors_[i].Trace();
+    }
+#endif
+
+    TraceBuffer::WriteChromeTrace(out, buffers);
+}
+
+/*static*/ void TaskManager::TagTask([[maybe_unused]] char const* tag)
+{
+#if defined(TASKWEAVER_TRACING)
+    if (Executor::HasThreadExecutor())
+        Executor::ThreadExecutor().TagTask(tag);
+#endif
+}
+
+auto TaskManager::HasPendingTasks() const -> bool
+{
+    for (auto i = size_t{ 0 }; i < executorCount_; i++) {
+        if (!executors_[i].IsQueueEmpty())
+            return true;
+    }
+
+    return !injectionQueue_.IsEmpty();
 }
 
 #if defined(ALLOW_THREAD_EXCEPTIONS_PROPAGATION)
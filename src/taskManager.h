@@ -7,14 +7,51 @@
 
 #include "common.h"
 #include "executor.h"
+#include "injectionQueue.h"
+#include "timerWheel.h"
+#include "topology.h"
 
 namespace taskweaver {
+struct task_manager_options_t
+{
+    // initial capacity of executor deques, they grow on demand
+    size_t taskQueueSize = 256;
+
+    // capacity of the queue for tasks posted by non executor threads
+    size_t injectionQueueSize = 1024;
+
+    // threads which run tasks, plus the main thread unless it is one of them
+    size_t threadPoolSize = std::max(std::thread::hardware_concurrency(), 1u);
+
+    // the main thread runs its executor by TaskManager::Run* calls
+    bool mainThreadWorker = false;
+
+    // every executor thread is bound to its own cpu of the topology, the main thread only if it is a worker
+    bool pinThreads = false;
+
+    // cpus the executor threads are restricted to, all the allowed cpus if it is empty
+    std::vector<uint32_t> cpuset = {};
+
+    // steal rounds without success on the own numa node before an executor robs other nodes
+    uint32_t remoteStealBackoff = 16;
+
+    // events kept per executor, the oldest ones are overwritten, used with TASKWEAVER_TRACING only
+    size_t traceBufferSize = size_t{ 1 } << 14;
+};
+
 class TaskManager
 {
     friend class Executor;
 
 public:
-    TaskManager(size_t taskQueueSize = 256, size_t threadPoolSize = std::max(std::thread::hardware_concurrency(), 1u));
+    // taskQueueSize is initial capacity of executor deques, they grow on demand
+    // injectionQueueSize is capacity of the queue for tasks posted by non executor threads
+    TaskManager(size_t taskQueueSize = 256,
+                size_t threadPoolSize = std::max(std::thread::hardware_concurrency(), 1u),
+                size_t injectionQueueSize = 1024);
+
+    // with the main thread as a worker the pool has threadPoolSize - 1 threads, so cores are not oversubscribed
+    explicit TaskManager(task_manager_options_t const& options);
 
     TaskManager(TaskManager const&) = delete;
 
@@ -30,12 +67,78 @@ public:
 
     [[nodiscard]] auto ExecutorCount() const -> uint32_t { return executorCount_; }
 
+    // sums of the executor counters, the depth is the maximum, see executor_stats_t,
+    // all zeros without TASKWEAVER_STATISTICS
+    [[nodiscard]] auto Stats() const -> executor_stats_t;
+
+    // executors record task runs, steals and parks while the tracing is on,
+    // nothing is recorded unless the library is built with TASKWEAVER_TRACING
+    void StartTracing();
+
+    void StopTracing();
+
+    // Chrome trace event json, viewable in Perfetto, the tracing must be stopped
+    void WriteTrace(std::ostream& out) const;
+
+    // names the running task in the trace, the tag must live until the trace is written
+    static void TagTask(char const* tag);
+
+    [[nodiscard]] auto Topology() const -> taskweaver::Topology const& { return topology_; }
+
     void Start();
 
     void Stop();
 
+    // the main thread runs its own executor: own tasks newest first, then injected, stolen and expired ones,
+    // runs one pending task if there is any, never sleeps
+    auto RunOne() -> bool;
+
+    // runs tasks until the predicate holds, it is checked after every task and every millisecond while idle
+    template<typename Predicate>
+    void RunUntil(Predicate&& predicate);
+
+    template<typename Rep, typename Period>
+    void RunFor(std::chrono::duration<Rep, Period> duration);
+
+    template<typename F>
+    static auto SubmitTask(F&& f) -> std::enable_if_t<std::is_invocable_v<F>, Future<std::invoke_result_t<F>>>;
+
+    template<typename F>
+    static auto SubmitTask(TaskPriority priority, F&& f)
+      -> std::enable_if_t<std::is_invocable_v<F>, Future<std::invoke_result_t<F>>>;
+
+    // the task is skipped if the stop is requested before it starts, see Executor::SubmitTask
+    template<internal::StoppableTaskConcept F>
+    static auto SubmitTask(std::stop_token token, F&& f) -> Future<internal::stoppable_task_result_t<F>>;
+
+    template<internal::StoppableTaskConcept F>
+    static auto SubmitTask(TaskPriority priority, std::stop_token token, F&& f)
+      -> Future<internal::stoppable_task_result_t<F>>;
+
+    // fire and forget, can be called in executor threads only
+    template<typename F>
+    static auto Dispatch(F&& f) -> std::enable_if_t<std::is_invocable_v<F>>;
+
     template<typename F>
-    static auto SubmitTask(F&& f) -> std::enable_if_t<std::is_invocable_v<F>, std::future<std::invoke_result_t<F>>>;
+    static auto Dispatch(TaskPriority priority, F&& f) -> std::enable_if_t<std::is_invocable_v<F>>;
+
+    // can be called in any thread, including threads which do not own an executor,
+    // a full injection queue makes the caller sleep until the executors take some tasks,
+    // a stopped task manager runs the task in the calling thread
+    template<typename F>
+    auto Post(F&& f) -> std::enable_if_t<std::is_invocable_v<F>, Future<std::invoke_result_t<F>>>;
+
+    // can be called in any thread, the task goes to the high priority lane of an executor
+    // once the delay is over, timers have millisecond resolution and never fire early
+    template<typename Rep, typename Period, typename F>
+    auto SubmitAfter(std::chrono::duration<Rep, Period> delay, F&& f)
+      -> std::enable_if_t<std::is_invocable_v<F>, Future<std::invoke_result_t<F>>>;
+
+    // can be called in any thread, the task runs every period until it is cancelled by the handle,
+    // runs never overlap, missed periods are skipped, a task which throws is not run any more
+    template<typename Rep, typename Period, typename F>
+    [[nodiscard]] auto SubmitEvery(std::chrono::duration<Rep, Period> period, F&& f)
+      -> std::enable_if_t<std::is_invocable_v<F>, TimerHandle>;
 
 #if defined(ALLOW_THREAD_EXCEPTIONS_PROPAGATION)
     auto GetLastException() -> std::exception_ptr;
@@ -46,6 +149,46 @@ private:
 
     [[nodiscard]] auto Executors() -> std::unique_ptr<Executor[]>& { return executors_; }
 
+    [[nodiscard]] auto Injection() -> InjectionQueue& { return injectionQueue_; }
+
+    [[nodiscard]] auto RemoteStealBackoff() const -> uint32_t { return remoteStealBackoff_; }
+
+#if defined(TASKWEAVER_TRACING)
+    [[nodiscard]] auto IsTracing() const -> bool { return tracing_.load(std::memory_order_relaxed); }
+#endif
+
+    // waits until all the bound threads have placed their memory, the last one wakes up the others
+    void WaitPlacingThreads(uint32_t placing);
+
+    // cpus the thread of the executor is bound to, empty if the thread is not bound
+    [[nodiscard]] auto Affinity(size_t executor) const -> std::vector<uint32_t>;
+
+    [[nodiscard]] auto MainExecutor() -> Executor&
+    {
+        assert(Executor::IsInMainThread());
+        return executors_[0];
+    }
+
+    [[nodiscard]] auto Timers() -> TimerWheel& { return timers_; }
+
+    void Schedule(internal::timer_node_t* timer, TimerWheel::clock_t::time_point deadline);
+
+    // the earliest deadline has moved closer, so the executor sleeping until the old one is woken up
+    void WakeTimerWatcher();
+
+    // moves the task into the injection queue, see Post
+    void Inject(Task& task);
+
+    // an executor has taken a task from the injection queue, so the posting threads waiting for a cell are woken up
+    void NotifyInjectionSpace();
+
+    // wakes up one parked executor if there is any
+    void NotifyOne();
+
+    void NotifyAll();
+
+    [[nodiscard]] auto HasPendingTasks() const -> bool;
+
 #if defined(ALLOW_THREAD_EXCEPTIONS_PROPAGATION)
     void PropagateException(std::exception_ptr const& exception);
 #endif
@@ -53,11 +196,38 @@ private:
 private:
     std::vector<std::thread> threadPool_;
 
+    taskweaver::Topology topology_;
+    bool mainThreadWorker_;
+    bool pinThreads_;
+    bool restricted_; // threads are bound to the cpuset at least
+    std::vector<uint32_t> mainThreadAffinity_; // restored on stop if the main thread was bound
+    uint32_t remoteStealBackoff_;
+    std::atomic<uint32_t> placingThreads_; // bound threads which allocate memory on their nodes at start
+
+#if defined(TASKWEAVER_TRACING)
+    size_t traceBufferSize_;
+    std::chrono::steady_clock::time_point traceEpoch_;
+    std::atomic<bool> tracing_;
+#endif
+
     size_t executorCount_;
     std::unique_ptr<Executor[]> executors_;
 
+    InjectionQueue injectionQueue_;
+    alignas(hardware_destructive_interference_size) std::atomic<uint32_t> injectionSpace_; // futex of the waiters
+    std::atomic<uint32_t> injectionWaiters_;
+#if defined(TASKWEAVER_STATISTICS)
+    std::atomic<uint64_t> injectionStalls_;
+#endif
+
+    TimerWheel timers_;
+    std::atomic<Executor*> timerWatcher_; // the parked executor which sleeps until the next deadline
+
     std::atomic<bool> alive_;
 
+    alignas(hardware_destructive_interference_size) std::atomic<uint32_t> parkedCount_;
+    std::atomic<uint32_t> notifyCursor_;
+
 #if defined(ALLOW_THREAD_EXCEPTIONS_PROPAGATION)
     std::mutex exPropagationMutex_;
     std::vector<std::exception_ptr> exceptions_;
@@ -66,10 +236,111 @@ private:
 
 template<typename F>
 /*static*/ auto TaskManager::SubmitTask(F&& f)
-  -> std::enable_if_t<std::is_invocable_v<F>, std::future<std::invoke_result_t<F>>>
+  -> std::enable_if_t<std::is_invocable_v<F>, Future<std::invoke_result_t<F>>>
 {
     return Executor::ThreadExecutor().SubmitTask(std::forward<F>(f));
 }
+
+template<typename F>
+/*static*/ auto TaskManager::SubmitTask(TaskPriority priority, F&& f)
+  -> std::enable_if_t<std::is_invocable_v<F>, Future<std::invoke_result_t<F>>>
+{
+    return Executor::ThreadExecutor().SubmitTask(priority, std::forward<F>(f));
+}
+
+template<internal::StoppableTaskConcept F>
+/*static*/ auto TaskManager::SubmitTask(std::stop_token token, F&& f) -> Future<internal::stoppable_task_result_t<F>>
+{
+    return Executor::ThreadExecutor().SubmitTask(std::move(token), std::forward<F>(f));
+}
+
+template<internal::StoppableTaskConcept F>
+/*static*/ auto TaskManager::SubmitTask(TaskPriority priority, std::stop_token token, F&& f)
+  -> Future<internal::stoppable_task_result_t<F>>
+{
+    return Executor::ThreadExecutor().SubmitTask(priority, std::move(token), std::forward<F>(f));
+}
+
+template<typename F>
+/*static*/ auto TaskManager::Dispatch(F&& f) -> std::enable_if_t<std::is_invocable_v<F>>
+{
+    Executor::ThreadExecutor().Dispatch(std::forward<F>(f));
+}
+
+template<typename F>
+/*static*/ auto TaskManager::Dispatch(TaskPriority priority, F&& f) -> std::enable_if_t<std::is_invocable_v<F>>
+{
+    Executor::ThreadExecutor().Dispatch(priority, std::forward<F>(f));
+}
+
+template<typename Predicate>
+void TaskManager::RunUntil(Predicate&& predicate)
+{
+    MainExecutor().RunUntil(std::forward<Predicate>(predicate));
+}
+
+template<typename Rep, typename Period>
+void TaskManager::RunFor(std::chrono::duration<Rep, Period> duration)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::ceil<std::chrono::steady_clock::duration>(duration);
+    MainExecutor().RunUntil(deadline);
+}
+
+template<typename F>
+auto TaskManager::Post(F&& f) -> std::enable_if_t<std::is_invocable_v<F>, Future<std::invoke_result_t<F>>>
+{
+    // own executors submit into their deques, it is cheaper
+    if (Executor::HasThreadExecutor() && &Executor::ThreadExecutor().TaskManager() == this)
+        return Executor::ThreadExecutor().SubmitTask(std::forward<F>(f));
+
+    using result_type_t = std::invoke_result_t<F>;
+
+    auto promise = Promise<result_type_t>{};
+    auto future = promise.get_future();
+
+    auto task = Task{ [p = std::move(promise), f = std::forward<F>(f)]() mutable -> void { p.set_result_of(f); } };
+    Inject(task);
+
+    return future;
+}
+
+template<typename Rep, typename Period, typename F>
+auto TaskManager::SubmitAfter(std::chrono::duration<Rep, Period> delay, F&& f)
+  -> std::enable_if_t<std::is_invocable_v<F>, Future<std::invoke_result_t<F>>>
+{
+    using result_type_t = std::invoke_result_t<F>;
+
+    auto promise = Promise<result_type_t>{};
+    auto future = promise.get_future();
+
+    auto deadline = TimerWheel::clock_t::now() + delay;
+    auto* timer = new internal::timer_node_t{
+        timers_, 0, [p = std::move(promise), f = std::forward<F>(f)]() mutable -> void { p.set_result_of(f); }
+    };
+
+    Schedule(timer, deadline);
+
+    return future;
+}
+
+template<typename Rep, typename Period, typename F>
+auto TaskManager::SubmitEvery(std::chrono::duration<Rep, Period> period, F&& f)
+  -> std::enable_if_t<std::is_invocable_v<F>, TimerHandle>
+{
+    auto ticks = std::chrono::ceil<TimerWheel::tick_t>(period) / TimerWheel::tick_v;
+    assert(ticks > 0);
+
+    auto deadline = TimerWheel::clock_t::now() + period;
+    auto* timer = new internal::timer_node_t{ timers_, static_cast<uint64_t>(ticks), std::forward<F>(f) };
+
+    // one reference for the wheel, one for the handle
+    timer->add_ref();
+    auto handle = TimerHandle{ timer };
+
+    Schedule(timer, deadline);
+
+    return handle;
+}
 }
 
 #endif // TASKWEAVER_TASKMANAGER_H
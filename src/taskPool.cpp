@@ -3,29 +3,84 @@
 //
 
 #include "taskPool.h"
+#include <algorithm>
+#include <utility>
 
 namespace taskweaver {
 TaskPool::TaskPool(size_t size)
-  : size_{ size }
-  , tasks_{ make_unique_for_overwrite<Task[]>(size) }
+  : size_{ 0 }
+  , chunks_{}
+  , free_{ nullptr }
+  , remoteFree_{ nullptr }
 {
+    Grow(std::max(size, size_t{ 1 }));
+}
+
+void TaskPool::Grow(size_t count)
+{
+    auto& tasks = chunks_.emplace_back(make_unique_for_overwrite<Task[]>(count));
+
+    for (auto i = count; i > 0; i--) {
+        auto& task = tasks[i - 1];
+
+        task.pool_ = this;
+        task.nextFree_ = free_;
+        free_ = &task;
+    }
+
+    size_ += count;
+}
+
+void TaskPool::Reallocate()
+{
+    assert(remoteFree_.load(std::memory_order_relaxed) == nullptr);
+
+    auto size = size_;
+
+    chunks_.clear();
+    free_ = nullptr;
+    size_ = 0;
+
+    Grow(size);
 }
 
 auto TaskPool::WriteableTask() -> Task*
 {
-    auto* taskPtr = std::add_pointer_t<Task>{ nullptr };
+    // takes back all the slots released by other threads at once,
+    // so there is no ABA problem: the remote list has many producers, but the only consumer
+    if (free_ == nullptr)
+        free_ = remoteFree_.exchange(nullptr, std::memory_order_acquire);
+
+    // doubles the pool
+    if (free_ == nullptr)
+        Grow(size_);
 
-    for (auto i = size_t{ 0 }; i < size_; i++) {
-        auto& task = tasks_[i];
+    auto* task = free_;
 
-        // it is safe, because each executor has own pool
-        // so, false negative condition because of races is not possible
-        if (!task.pending()) {
-            taskPtr = &task;
-            break;
-        }
+    if (task != nullptr) {
+        free_ = std::exchange(task->nextFree_, nullptr);
     }
 
-    return taskPtr;
+    return task;
+}
+
+void TaskPool::Release(Task* task)
+{
+    assert(task->pool_ == this && !task->pending());
+
+    task->nextFree_ = free_;
+    free_ = task;
+}
+
+void TaskPool::ReleaseRemote(Task* task)
+{
+    assert(task->pool_ == this && !task->pending());
+
+    auto* head = remoteFree_.load(std::memory_order_relaxed);
+
+    do {
+        task->nextFree_ = head;
+    } while (
+      !remoteFree_.compare_exchange_weak(head, task, std::memory_order_release, std::memory_order_relaxed));
 }
 }
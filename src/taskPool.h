@@ -17,19 +17,41 @@ public:
 
     TaskPool(TaskPool const&) = delete;
 
-    TaskPool(TaskPool&&) = default;
+    TaskPool(TaskPool&&) = delete;
 
     ~TaskPool() = default;
 
     auto operator=(TaskPool const&) -> TaskPool& = delete;
 
-    auto operator=(TaskPool&&) -> TaskPool& = default;
+    auto operator=(TaskPool&&) -> TaskPool& = delete;
 
+    // can be called in owner thread only
+    // allocates one more chunk of slots if all of them are taken
     auto WriteableTask() -> Task*;
 
+    [[nodiscard]] auto Size() const -> size_t { return size_; }
+
+    // allocates the slots again in the calling thread, so they are first touched on its numa node,
+    // can be called by the owner thread while no slot is taken
+    void Reallocate();
+
+    // returns the task slot into the pool, can be called in owner thread only
+    void Release(Task* task);
+
+    // returns the task slot into the pool, can be called in any thread
+    void ReleaseRemote(Task* task);
+
+    static auto Owner(Task const& task) -> TaskPool* { return task.pool_; }
+
+private:
+    void Grow(size_t count);
+
 private:
     size_t size_;
-    std::unique_ptr<Task[]> tasks_;
+    std::vector<std::unique_ptr<Task[]>> chunks_; // slots never move, other threads keep pointers to them
+
+    Task* free_; // intrusive free list, owner thread only
+    alignas(hardware_destructive_interference_size) std::atomic<Task*> remoteFree_; // slots released by others
 };
 }
 
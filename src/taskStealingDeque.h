@@ -6,6 +6,8 @@
 #define TASKWEAVER_TASKSTEALINGDEQUE_H
 
 #include "common.h"
+#include <algorithm>
+#include <bit>
 #include <cassert>
 #include <optional>
 
@@ -15,8 +17,13 @@ concept DequeItemConcept = (std::is_nothrow_move_assignable_v<T> && std::is_noth
                             std::is_nothrow_copy_assignable_v<T> && std::is_nothrow_copy_constructible_v<T>);
 
 // circular work-stealing deque, SPMC and lock free
-// the same idea as in paper below, but with static size ring
+// the same idea as in paper below, the ring grows when it's full
 // https://www.dre.vanderbilt.edu/~schmidt/PDF/work-stealing-dequeue.pdf
+// replaced rings are kept alive until the deque is destroyed,
+// since thieves may still read from them
+// thieves may take several items at once, so the producer pops without CAS
+// only while there are more than steal_batch_max_v items ahead of the bottom,
+// otherwise it claims the rest of items with CAS and puts back all of them but the last one
 template<DequeItemConcept T>
 class TaskStealingDeque
 {
@@ -24,14 +31,14 @@ class TaskStealingDeque
     {
         explicit data_t(size_t capacity);
 
-        [[nodiscard]] auto capacity() const -> size_t { return capacity_; }
+        [[nodiscard]] auto capacity() const -> size_t { return mask_ + 1; }
 
         void store(size_t index, T&& t) noexcept;
 
         auto load(size_t index) noexcept -> T;
 
     private:
-        size_t capacity_;
+        size_t mask_; // capacity is power of two
         std::unique_ptr<T[]> data_;
     };
 
@@ -40,25 +47,46 @@ public:
 
     ~TaskStealingDeque();
 
-    [[nodiscard]] auto Capacity() const -> size_t { return data_->capacity(); }
+    [[nodiscard]] auto Capacity() const -> size_t { return data_.load(std::memory_order_relaxed)->capacity(); }
 
     [[nodiscard]] auto IsEmpty() const -> bool;
 
+    // exact in producer thread only
+    [[nodiscard]] auto Size() const -> size_t { return CountItems(); }
+
     // can be called in producer thread only
+    // fails if there is no free space
     template<typename... Args>
     auto TryEmplace(Args&&... args) -> bool;
 
+    // can be called in producer thread only
+    // grows the ring if there is no free space
+    template<typename... Args>
+    void Emplace(Args&&... args);
+
     // can be called in any thread, but
     // it's maden in purpose of consumer threads
     // in producer thread better use TryPop method instead
     auto TrySteal() -> std::optional<T>;
 
+    // steals up to a half of the items (but no more than steal_batch_max_v) with a single CAS,
+    // returns the oldest one and moves the rest into the dst deque (growing it if needed),
+    // can be called in the dst producer thread only
+    auto TryStealBatch(TaskStealingDeque& dst, size_t* stolenCount = nullptr) -> std::optional<T>;
+
     // can be called in producer thread only
     auto TryPop() -> std::optional<T>;
 
+    // max number of items a single steal can take
+    static constexpr size_t steal_batch_max_v = 8;
+
 private:
     [[nodiscard]] auto CountItems() const -> size_t;
 
+    auto TryStealItems(size_t maxCount, T* items) -> size_t;
+
+    auto Grow(uint64_t bottom, uint64_t top) -> data_t*;
+
 #if defined(TESTING)
 public:
 #endif
@@ -67,40 +95,43 @@ public:
 #if defined(TESTING)
 private:
 #endif
-    alignas(hardware_destructive_interference_size) data_t* data_;
+    alignas(hardware_destructive_interference_size) std::atomic<data_t*> data_;
+    std::vector<std::unique_ptr<data_t>> retired_; // producer thread only
 };
 
 template<DequeItemConcept T>
 TaskStealingDeque<T>::data_t::data_t(size_t capacity)
-  : capacity_{ capacity }
+  : mask_{ capacity - 1 }
   , data_{ make_unique_for_overwrite<T[]>(capacity) }
 {
+    assert(std::has_single_bit(capacity));
 }
 
 template<DequeItemConcept T>
 void TaskStealingDeque<T>::data_t::store(size_t index, T&& t) noexcept
 {
-    data_[index % capacity_] = std::move(t);
+    data_[index & mask_] = std::move(t);
 }
 
 template<DequeItemConcept T>
 auto TaskStealingDeque<T>::data_t::load(size_t index) noexcept -> T
 {
-    return data_[index % capacity_];
+    return data_[index & mask_];
 }
 
 template<DequeItemConcept T>
 TaskStealingDeque<T>::TaskStealingDeque(size_t capacity)
   : top_{ 0 }
   , bottom_{ 0 }
-  , data_{ new data_t{ capacity } }
+  , data_{ new data_t{ std::bit_ceil(std::max(capacity, steal_batch_max_v * 2)) } }
+  , retired_{}
 {
 }
 
 template<DequeItemConcept T>
 TaskStealingDeque<T>::~TaskStealingDeque()
 {
-    delete data_;
+    delete data_.load(std::memory_order_relaxed);
 }
 
 template<DequeItemConcept T>
@@ -111,7 +142,8 @@ auto TaskStealingDeque<T>::IsEmpty() const -> bool
     auto bottom = bottom_.load(std::memory_order_acquire);
     auto top = top_.load(std::memory_order_acquire);
 
-    return top == bottom;
+    // bottom can be behind top for a moment while producer pops
+    return static_cast<int64_t>(bottom - top) <= 0;
 }
 
 template<DequeItemConcept T>
@@ -120,40 +152,120 @@ auto TaskStealingDeque<T>::CountItems() const -> size_t
     auto bottom = bottom_.load(std::memory_order_relaxed);
     auto top = top_.load(std::memory_order_acquire);
 
-    return static_cast<size_t>((bottom >= top) ? bottom - top : (std::numeric_limits<uint64_t>::max() - top + bottom));
+    // unsigned arithmetic handles overflow of indices
+    return static_cast<size_t>(bottom - top);
 }
 
 template<DequeItemConcept T>
 template<typename... Args>
 auto TaskStealingDeque<T>::TryEmplace(Args&&... args) -> bool
 {
-    if (CountItems() < Capacity()) {
-        data_->store(static_cast<size_t>(bottom_.load(std::memory_order_relaxed)), T(std::forward<Args>(args)...));
-        bottom_.fetch_add(1, std::memory_order_relaxed);
+    auto bottom = bottom_.load(std::memory_order_relaxed);
+    auto top = top_.load(std::memory_order_acquire);
+
+    if (static_cast<size_t>(bottom - top) < Capacity()) {
+        data_.load(std::memory_order_relaxed)->store(static_cast<size_t>(bottom), T(std::forward<Args>(args)...));
+        bottom_.store(bottom + 1, std::memory_order_release);
         return true;
     }
 
     return false;
 }
 
+template<DequeItemConcept T>
+template<typename... Args>
+void TaskStealingDeque<T>::Emplace(Args&&... args)
+{
+    auto bottom = bottom_.load(std::memory_order_relaxed);
+    auto top = top_.load(std::memory_order_acquire);
+    auto* data = data_.load(std::memory_order_relaxed);
+
+    if (static_cast<size_t>(bottom - top) >= data->capacity()) {
+        data = Grow(bottom, top);
+    }
+
+    data->store(static_cast<size_t>(bottom), T(std::forward<Args>(args)...));
+    bottom_.store(bottom + 1, std::memory_order_release);
+}
+
+template<DequeItemConcept T>
+auto TaskStealingDeque<T>::Grow(uint64_t bottom, uint64_t top) -> data_t*
+{
+    auto* data = data_.load(std::memory_order_relaxed);
+    auto* grown = new data_t{ data->capacity() * 2 };
+
+    // thieves might take some of them meanwhile, it's fine:
+    // they read from the old ring, which stays alive and unchanged
+    for (auto i = top; i != bottom; i++) {
+        grown->store(static_cast<size_t>(i), data->load(static_cast<size_t>(i)));
+    }
+
+    retired_.emplace_back(data);
+    data_.store(grown, std::memory_order_release);
+
+    return grown;
+}
+
+template<DequeItemConcept T>
+auto TaskStealingDeque<T>::TryStealItems(size_t maxCount, T* items) -> size_t
+{
+    auto top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto bottom = bottom_.load(std::memory_order_acquire);
+
+    auto size = static_cast<int64_t>(bottom - top);
+
+    if (size <= 0) // empty
+        return 0;
+
+    auto count = std::min(std::min(maxCount, steal_batch_max_v), static_cast<size_t>(size + 1) / 2);
+
+    // ring is published before the bottom it has grown for
+    auto* data = data_.load(std::memory_order_acquire);
+
+    for (auto i = size_t{ 0 }; i < count; i++) {
+        items[i] = data->load(static_cast<size_t>(top + i));
+    }
+
+    if (!top_.compare_exchange_strong(top, top + count, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return 0;
+
+    return count;
+}
+
 template<DequeItemConcept T>
 auto TaskStealingDeque<T>::TrySteal() -> std::optional<T>
 {
     auto result = std::optional<T>{ std::nullopt };
 
-    auto top = top_.load(std::memory_order_acquire);
+    auto item = T{};
+    if (TryStealItems(1, &item) != 0) {
+        result = std::move(item);
+    }
 
-    std::atomic_thread_fence(std::memory_order_release);
-    auto bottom = bottom_.load(std::memory_order_acquire);
+    return result;
+}
 
-    if (top != bottom) { // not empty
-        result = data_->load(static_cast<size_t>(top));
+template<DequeItemConcept T>
+auto TaskStealingDeque<T>::TryStealBatch(TaskStealingDeque& dst, size_t* stolenCount /* = nullptr*/)
+  -> std::optional<T>
+{
+    auto result = std::optional<T>{ std::nullopt };
+
+    auto items = std::array<T, steal_batch_max_v>{};
+    auto count = TryStealItems(steal_batch_max_v, items.data());
 
-        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_acq_rel, std::memory_order_relaxed)) {
-            result = std::nullopt;
+    if (count > 0) {
+        for (auto i = size_t{ 1 }; i < count; i++) {
+            dst.Emplace(std::move(items[i]));
         }
+
+        result = std::move(items[0]);
     }
 
+    if (stolenCount != nullptr)
+        *stolenCount = count;
+
     return result;
 }
 
@@ -161,19 +273,43 @@ template<DequeItemConcept T>
 auto TaskStealingDeque<T>::TryPop() -> std::optional<T>
 {
     auto result = std::optional<T>{ std::nullopt };
+    auto* data = data_.load(std::memory_order_relaxed);
 
-    auto bottom = bottom_.load(std::memory_order_relaxed);
-    auto top = top_.load(std::memory_order_acquire);
+    while (true) {
+        auto bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        bottom_.store(bottom, std::memory_order_relaxed);
 
-    if (bottom != top) { // not empty
-        auto prev = bottom--;
-        bottom_.store(bottom, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
 
-        if (prev == top_.load(std::memory_order_acquire)) { // someone stole everything
+        auto top = top_.load(std::memory_order_relaxed);
+        auto size = static_cast<int64_t>(bottom - top); // items left after the pop
+
+        if (size < 0) { // empty
             bottom_.store(bottom + 1, std::memory_order_relaxed);
-        } else {
-            result = data_->load(static_cast<size_t>(bottom));
+            break;
+        }
+
+        if (size >= static_cast<int64_t>(steal_batch_max_v)) {
+            // no batch can reach the bottom, even if its thief has seen the old bottom
+            result = data->load(static_cast<size_t>(bottom));
+            break;
+        }
+
+        // claims the whole [top, bottom] range
+        if (top_.compare_exchange_strong(top, bottom + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            result = data->load(static_cast<size_t>(bottom));
+
+            // puts back [top, bottom) range in the same order
+            for (auto i = uint64_t{ 0 }, count = bottom - top; i < count; i++) {
+                data->store(static_cast<size_t>(bottom + 1 + i), data->load(static_cast<size_t>(top + i)));
+            }
+
+            bottom_.store(bottom + 1 + (bottom - top), std::memory_order_release);
+            break;
         }
+
+        // a thief was faster, restores bottom and tries again
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
     }
 
     return result;
@@ -0,0 +1,287 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#include "timerWheel.h"
+#include <bit>
+#include <limits>
+
+namespace taskweaver {
+namespace {
+constexpr auto no_deadline_v = std::numeric_limits<TimerWheel::clock_t::rep>::max();
+constexpr auto no_tick_v = std::numeric_limits<uint64_t>::max();
+
+constexpr auto level_shift(size_t level) -> size_t
+{
+    return level * TimerWheel::slot_bits_v;
+}
+
+// index of the block of ticks the tick belongs to on the level
+constexpr auto block_of(uint64_t tick, size_t level) -> uint64_t
+{
+    return tick >> level_shift(level);
+}
+}
+
+TimerWheel::TimerWheel()
+  : mutex_{}
+  , lists_{}
+  , occupied_{}
+  , now_{ 0 }
+  , size_{ 0 }
+  , start_{ clock_t::now() }
+  , nextDeadline_{ no_deadline_v }
+{
+}
+
+TimerWheel::~TimerWheel()
+{
+    Clear();
+}
+
+auto TimerWheel::Size() const -> size_t
+{
+    auto lock = std::lock_guard<std::mutex>{ mutex_ };
+    return size_;
+}
+
+auto TimerWheel::TickOf(clock_t::time_point time) const -> uint64_t
+{
+    if (time <= start_)
+        return 0;
+
+    // rounded up, a timer never fires before its deadline
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(time - start_);
+    auto tick = std::chrono::duration_cast<std::chrono::nanoseconds>(tick_v);
+
+    return static_cast<uint64_t>((elapsed.count() + tick.count() - 1) / tick.count());
+}
+
+auto TimerWheel::TimeOf(uint64_t tick) const -> clock_t::time_point
+{
+    return start_ + std::chrono::duration_cast<clock_t::duration>(tick_v) * static_cast<clock_t::rep>(tick);
+}
+
+auto TimerWheel::Insert(internal::timer_node_t* timer, clock_t::time_point deadline) -> bool
+{
+    auto lock = std::unique_lock<std::mutex>{ mutex_ };
+
+    // checked under the lock, so a cancel either sees the timer linked or the timer is not linked at all
+    if (timer->cancelled.load(std::memory_order_acquire)) {
+        lock.unlock();
+        timer->release();
+        return false;
+    }
+
+    timer->expiry = TickOf(deadline);
+    Link(timer);
+    size_++;
+
+    return PublishNextDeadline();
+}
+
+auto TimerWheel::Rearm(internal::timer_node_t* timer) -> bool
+{
+    assert(timer->period != 0);
+
+    auto now = TickOf(clock_t::now());
+    auto expiry = timer->expiry + timer->period;
+
+    if (expiry <= now)
+        expiry += ((now - expiry) / timer->period + 1) * timer->period;
+
+    return Insert(timer, TimeOf(expiry));
+}
+
+auto TimerWheel::Cancel(internal::timer_node_t* timer) -> bool
+{
+    {
+        auto lock = std::lock_guard<std::mutex>{ mutex_ };
+
+        if (!timer->linked)
+            return false;
+
+        Unlink(timer);
+        size_--;
+        PublishNextDeadline();
+    }
+
+    timer->task.reset();
+    timer->release();
+
+    return true;
+}
+
+auto TimerWheel::Expire(clock_t::time_point now) -> internal::timer_node_t*
+{
+    auto lock = std::unique_lock<std::mutex>{ mutex_, std::try_to_lock };
+
+    if (!lock.owns_lock())
+        return nullptr;
+
+    // timers with deadline not later than now
+    if (now > start_)
+        Advance(static_cast<uint64_t>((now - start_) / tick_v));
+
+    auto* expired = std::exchange(lists_[due_list_v], nullptr);
+
+    for (auto* timer = expired; timer != nullptr; timer = timer->next) {
+        timer->linked = false;
+        size_--;
+    }
+
+    PublishNextDeadline();
+
+    return expired;
+}
+
+void TimerWheel::Clear()
+{
+    auto lock = std::lock_guard<std::mutex>{ mutex_ };
+
+    for (auto list = size_t{ 0 }; list < lists_.size(); list++) {
+        while (auto* timer = lists_[list]) {
+            Unlink(timer);
+
+            timer->cancelled.store(true, std::memory_order_release);
+            timer->task.reset();
+            timer->release();
+        }
+    }
+
+    occupied_.fill(0);
+    size_ = 0;
+    nextDeadline_.store(no_deadline_v, std::memory_order_release);
+}
+
+void TimerWheel::Link(internal::timer_node_t* timer)
+{
+    auto expiry = timer->expiry;
+
+    if (expiry <= now_) {
+        PushFront(due_list_v, timer);
+        return;
+    }
+
+    // the lowest level where the timer shares the parent block with the current tick,
+    // so the slot of the timer is always ahead of the current slot of the level
+    for (auto level = size_t{ 0 }; level < levels_v; level++) {
+        if (block_of(expiry, level + 1) == block_of(now_, level + 1)) {
+            auto slot = static_cast<size_t>(block_of(expiry, level) & (slots_v - 1));
+
+            PushFront(level * slots_v + slot, timer);
+            occupied_[level] |= uint64_t{ 1 } << slot;
+            return;
+        }
+    }
+
+    PushFront(overflow_list_v, timer);
+}
+
+void TimerWheel::PushFront(size_t list, internal::timer_node_t* timer)
+{
+    auto*& head = lists_[list];
+
+    timer->prev = nullptr;
+    timer->next = head;
+    timer->list = static_cast<uint32_t>(list);
+    timer->linked = true;
+
+    if (head != nullptr)
+        head->prev = timer;
+
+    head = timer;
+}
+
+void TimerWheel::Unlink(internal::timer_node_t* timer)
+{
+    auto list = static_cast<size_t>(timer->list);
+
+    if (timer->prev != nullptr) {
+        timer->prev->next = timer->next;
+    } else {
+        lists_[list] = timer->next;
+    }
+
+    if (timer->next != nullptr)
+        timer->next->prev = timer->prev;
+
+    if (list < wheel_lists_v && lists_[list] == nullptr)
+        occupied_[list / slots_v] &= ~(uint64_t{ 1 } << (list % slots_v));
+
+    timer->prev = nullptr;
+    timer->next = nullptr;
+    timer->linked = false;
+}
+
+void TimerWheel::Redistribute(size_t list)
+{
+    auto* timer = std::exchange(lists_[list], nullptr);
+
+    if (list < wheel_lists_v)
+        occupied_[list / slots_v] &= ~(uint64_t{ 1 } << (list % slots_v));
+
+    while (timer != nullptr) {
+        auto* next = timer->next;
+        Link(timer);
+        timer = next;
+    }
+}
+
+void TimerWheel::Step()
+{
+    now_++;
+
+    // a new block of the upper levels has started, its timers go down
+    if (block_of(now_, levels_v) << level_shift(levels_v) == now_)
+        Redistribute(overflow_list_v);
+
+    for (auto level = levels_v - 1; level > 0; level--) {
+        if (block_of(now_, level) << level_shift(level) == now_)
+            Redistribute(level * slots_v + static_cast<size_t>(block_of(now_, level) & (slots_v - 1)));
+    }
+
+    // timers of the current tick are due
+    Redistribute(static_cast<size_t>(now_ & (slots_v - 1)));
+}
+
+void TimerWheel::Advance(uint64_t tick)
+{
+    while (now_ < tick) {
+        auto next = NextTick();
+
+        // nothing happens on the ticks in between
+        if (next > tick) {
+            now_ = tick;
+            break;
+        }
+
+        now_ = std::max(now_, next - 1);
+        Step();
+    }
+}
+
+auto TimerWheel::NextTick() const -> uint64_t
+{
+    // timers of a lower level are earlier than timers of the upper ones
+    for (auto level = size_t{ 0 }; level < levels_v; level++) {
+        if (occupied_[level] != 0) {
+            auto slot = static_cast<uint64_t>(std::countr_zero(occupied_[level]));
+            return (block_of(now_, level + 1) << level_shift(level + 1)) | (slot << level_shift(level));
+        }
+    }
+
+    if (lists_[overflow_list_v] != nullptr)
+        return (block_of(now_, levels_v) + 1) << level_shift(levels_v);
+
+    return no_tick_v;
+}
+
+auto TimerWheel::PublishNextDeadline() -> bool
+{
+    auto tick = (lists_[due_list_v] != nullptr) ? now_ : NextTick();
+    auto deadline = (tick == no_tick_v) ? no_deadline_v : TimeOf(tick).time_since_epoch().count();
+
+    return nextDeadline_.exchange(deadline, std::memory_order_acq_rel) > deadline;
+}
+}
@@ -0,0 +1,211 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#ifndef TASKWEAVER_TIMERWHEEL_H
+#define TASKWEAVER_TIMERWHEEL_H
+
+#include "task.h"
+#include <mutex>
+#include <utility>
+
+namespace taskweaver {
+class TimerWheel;
+
+namespace internal {
+// delayed or periodic task, linked into a slot of the wheel,
+// one reference is held by the wheel while the timer is pending or firing, one more by the handle if any
+struct timer_node_t
+{
+    template<typename F>
+    timer_node_t(TimerWheel& wheel, uint64_t period, F&& f)
+      : prev{ nullptr }
+      , next{ nullptr }
+      , list{ 0 }
+      , linked{ false }
+      , expiry{ 0 }
+      , period{ period }
+      , wheel{ &wheel }
+      , task{ std::forward<F>(f) }
+      , refs{ 1 }
+      , cancelled{ false }
+    {
+    }
+
+    void add_ref() { refs.fetch_add(1, std::memory_order_relaxed); }
+
+    void release()
+    {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete this;
+    }
+
+    // guarded by the wheel mutex
+    timer_node_t* prev;
+    timer_node_t* next;
+    uint32_t list; // slot, overflow or due list the timer is linked into
+    bool linked;
+    uint64_t expiry; // in ticks of the wheel
+
+    uint64_t const period; // in ticks, zero for one shot timers
+    TimerWheel* wheel;
+    Task task;
+    std::atomic<uint32_t> refs;
+    std::atomic<bool> cancelled;
+};
+} // internal
+
+// hierarchical timer wheel with millisecond ticks: 4 levels of 64 slots cover about 4.6 hours,
+// later timers wait in the overflow list and are redistributed once per full turn,
+// insert and cancel are O(1) under the mutex, expiration moves timers down the levels in bulk,
+// the wheel is advanced by executors which found no work, the earliest deadline is readable without lock
+class TimerWheel
+{
+public:
+    using clock_t = std::chrono::steady_clock;
+    using tick_t = std::chrono::milliseconds;
+
+    static constexpr auto tick_v = tick_t{ 1 };
+    static constexpr auto slot_bits_v = size_t{ 6 };
+    static constexpr auto slots_v = size_t{ 1 } << slot_bits_v;
+    static constexpr auto levels_v = size_t{ 4 };
+
+    TimerWheel();
+
+    TimerWheel(TimerWheel const&) = delete;
+
+    TimerWheel(TimerWheel&&) = delete;
+
+    ~TimerWheel();
+
+    auto operator=(TimerWheel const&) -> TimerWheel& = delete;
+
+    auto operator=(TimerWheel&&) -> TimerWheel& = delete;
+
+    // can be called in any thread, the wheel takes over the reference of the caller,
+    // a cancelled timer is released instead, returns whether the earliest deadline moved closer
+    auto Insert(internal::timer_node_t* timer, clock_t::time_point deadline) -> bool;
+
+    // next firing of a periodic timer, missed periods are skipped
+    auto Rearm(internal::timer_node_t* timer) -> bool;
+
+    // can be called in any thread, returns whether the timer was pending and will not fire,
+    // a periodic timer which is firing at the moment is not rearmed
+    auto Cancel(internal::timer_node_t* timer) -> bool;
+
+    // expired timers as a list linked by next, the wheel references are passed to the caller,
+    // nullptr if nothing expired or other thread is advancing the wheel
+    auto Expire(clock_t::time_point now) -> internal::timer_node_t*;
+
+    // releases all the pending timers without running them
+    void Clear();
+
+    // the earliest deadline, a lower bound for timers on the upper levels,
+    // time_point::max() if there are no timers
+    [[nodiscard]] auto NextDeadline() const -> clock_t::time_point
+    {
+        return clock_t::time_point{ clock_t::duration{ nextDeadline_.load(std::memory_order_acquire) } };
+    }
+
+    [[nodiscard]] auto Size() const -> size_t;
+
+private:
+    static constexpr auto wheel_lists_v = levels_v * slots_v;
+    static constexpr auto overflow_list_v = wheel_lists_v;
+    static constexpr auto due_list_v = wheel_lists_v + 1;
+
+    [[nodiscard]] auto TickOf(clock_t::time_point time) const -> uint64_t;
+
+    [[nodiscard]] auto TimeOf(uint64_t tick) const -> clock_t::time_point;
+
+    void Link(internal::timer_node_t* timer);
+
+    void Unlink(internal::timer_node_t* timer);
+
+    void PushFront(size_t list, internal::timer_node_t* timer);
+
+    // moves the timers of the list into the wheel again, relative to the current tick
+    void Redistribute(size_t list);
+
+    void Step();
+
+    void Advance(uint64_t tick);
+
+    [[nodiscard]] auto NextTick() const -> uint64_t;
+
+    // returns whether the deadline moved closer
+    auto PublishNextDeadline() -> bool;
+
+private:
+    mutable std::mutex mutex_;
+    std::array<internal::timer_node_t*, due_list_v + 1> lists_;
+    std::array<uint64_t, levels_v> occupied_; // a bit per non empty slot
+    uint64_t now_; // the last processed tick
+    size_t size_;
+    clock_t::time_point start_;
+
+    alignas(hardware_destructive_interference_size) std::atomic<clock_t::rep> nextDeadline_;
+};
+
+// cancels a periodic task, dropping the handle leaves the task running until the task manager stops
+class TimerHandle
+{
+public:
+    TimerHandle()
+      : timer_{ nullptr }
+    {
+    }
+
+    explicit TimerHandle(internal::timer_node_t* timer)
+      : timer_{ timer }
+    {
+    }
+
+    TimerHandle(TimerHandle const&) = delete;
+
+    TimerHandle(TimerHandle&& other) noexcept
+      : timer_{ std::exchange(other.timer_, nullptr) }
+    {
+    }
+
+    ~TimerHandle() { reset(); }
+
+    auto operator=(TimerHandle const&) -> TimerHandle& = delete;
+
+    auto operator=(TimerHandle&& rhs) noexcept -> TimerHandle&
+    {
+        if (this != &rhs) {
+            reset();
+            timer_ = std::exchange(rhs.timer_, nullptr);
+        }
+
+        return *this;
+    }
+
+    [[nodiscard]] auto valid() const -> bool { return timer_ != nullptr; }
+
+    // must not race with the destruction of the task manager,
+    // returns whether the timer was pending, the task is not run any more anyway
+    auto cancel() -> bool
+    {
+        assert(valid());
+
+        if (timer_->cancelled.exchange(true, std::memory_order_acq_rel))
+            return false;
+
+        return timer_->wheel->Cancel(timer_);
+    }
+
+private:
+    void reset()
+    {
+        if (timer_ != nullptr)
+            std::exchange(timer_, nullptr)->release();
+    }
+
+private:
+    internal::timer_node_t* timer_;
+};
+}
+
+#endif // TASKWEAVER_TIMERWHEEL_H
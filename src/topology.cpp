@@ -0,0 +1,219 @@
+//
+// Created by anton on 10/18/26.
+//
+
+#include "topology.h"
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <string>
+#include <tuple>
+
+#if defined(__linux__)
+#include <filesystem>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace taskweaver {
+namespace {
+#if defined(__linux__)
+auto read_line(std::string const& path) -> std::optional<std::string>
+{
+    auto file = std::ifstream{ path };
+    auto line = std::string{};
+
+    if (!file || !std::getline(file, line))
+        return std::nullopt;
+
+    return line;
+}
+
+auto read_number(std::string const& path) -> std::optional<uint32_t>
+{
+    auto line = read_line(path);
+    auto value = uint32_t{ 0 };
+
+    if (!line || std::from_chars(line->data(), line->data() + line->size(), value).ec != std::errc{})
+        return std::nullopt;
+
+    return value;
+}
+
+// the lowest cpu sharing the cache of the level with the cpu, the cpu itself if the cache is unknown
+auto cache_group(std::string const& cpuPath, uint32_t cpu, uint32_t level) -> uint32_t
+{
+    for (auto index = 0;; index++) {
+        auto indexPath = cpuPath + "/cache/index" + std::to_string(index);
+        auto indexLevel = read_number(indexPath + "/level");
+
+        if (!indexLevel)
+            return cpu;
+
+        // instruction caches share the level with the data ones
+        if (indexLevel != level || read_line(indexPath + "/type") == "Instruction")
+            continue;
+
+        auto shared = read_line(indexPath + "/shared_cpu_list");
+        auto cpus = shared ? Topology::ParseCpuList(*shared) : std::vector<uint32_t>{};
+
+        return cpus.empty() ? cpu : cpus.front();
+    }
+}
+
+auto numa_node(std::string const& cpuPath) -> uint32_t
+{
+    auto error = std::error_code{};
+
+    for (auto const& entry : std::filesystem::directory_iterator{ cpuPath, error }) {
+        auto name = entry.path().filename().string();
+        auto node = uint32_t{ 0 };
+
+        if (name.starts_with("node") &&
+            std::from_chars(name.data() + 4, name.data() + name.size(), node).ec == std::errc{})
+            return node;
+    }
+
+    return 0;
+}
+
+auto read_cpu(uint32_t cpu) -> cpu_info_t
+{
+    auto cpuPath = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    auto package = read_number(cpuPath + "/topology/physical_package_id").value_or(0);
+
+    return cpu_info_t{ cpu,
+                       read_number(cpuPath + "/topology/core_id").value_or(cpu),
+                       cache_group(cpuPath, cpu, 2),
+                       cache_group(cpuPath, cpu, 3),
+                       numa_node(cpuPath),
+                       package };
+}
+#endif
+}
+
+Topology::Topology(std::vector<cpu_info_t> cpus)
+  : cpus_{ std::move(cpus) }
+{
+    assert(!cpus_.empty());
+
+    auto key = [](cpu_info_t const& c) -> auto { return std::tie(c.package, c.node, c.l3, c.l2, c.core, c.cpu); };
+
+    std::sort(cpus_.begin(), cpus_.end(), [&key](auto const& a, auto const& b) -> bool { return key(a) < key(b); });
+
+    // the n-th hyper-thread of each core goes after the (n-1)-th ones of all the cores
+    auto siblings = std::map<std::pair<uint32_t, uint32_t>, uint32_t>{};
+    auto ranks = std::vector<std::pair<uint32_t, cpu_info_t>>{};
+    ranks.reserve(cpus_.size());
+
+    for (auto const& cpu : cpus_) {
+        ranks.emplace_back(siblings[{ cpu.package, cpu.core }]++, cpu);
+    }
+
+    std::stable_sort(
+      ranks.begin(), ranks.end(), [](auto const& a, auto const& b) -> bool { return a.first < b.first; });
+
+    for (auto i = size_t{ 0 }; i < ranks.size(); i++) {
+        cpus_[i] = ranks[i].second;
+    }
+}
+
+/*static*/ auto Topology::Detect(std::vector<uint32_t> const& cpuset /* = {}*/) -> Topology
+{
+    auto allowed = ThreadAffinity();
+
+    if (!cpuset.empty()) {
+        std::erase_if(allowed, [&cpuset](uint32_t cpu) -> bool {
+            return std::find(cpuset.begin(), cpuset.end(), cpu) == cpuset.end();
+        });
+    }
+
+    // a cpuset without allowed cpus is ignored rather than leaving the pool without cpus
+    if (allowed.empty())
+        allowed = ThreadAffinity();
+
+    auto cpus = std::vector<cpu_info_t>{};
+    cpus.reserve(allowed.size());
+
+    for (auto cpu : allowed) {
+#if defined(__linux__)
+        cpus.push_back(read_cpu(cpu));
+#else
+        cpus.push_back(cpu_info_t{ cpu, cpu, 0, 0, 0, 0 });
+#endif
+    }
+
+    return Topology{ std::move(cpus) };
+}
+
+/*static*/ auto Topology::ParseCpuList(std::string_view list) -> std::vector<uint32_t>
+{
+    auto cpus = std::vector<uint32_t>{};
+
+    while (!list.empty()) {
+        auto comma = list.find(',');
+        auto range = list.substr(0, comma);
+        list = (comma == std::string_view::npos) ? std::string_view{} : list.substr(comma + 1);
+
+        auto first = uint32_t{ 0 };
+        auto [end, error] = std::from_chars(range.data(), range.data() + range.size(), first);
+
+        if (error != std::errc{})
+            continue;
+
+        auto last = first;
+        if (end != range.data() + range.size() && *end == '-')
+            std::from_chars(end + 1, range.data() + range.size(), last);
+
+        for (auto cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+
+    return cpus;
+}
+
+/*static*/ auto Topology::PinThread(std::vector<uint32_t> const& cpus) -> bool
+{
+#if defined(__linux__)
+    auto set = cpu_set_t{};
+    CPU_ZERO(&set);
+
+    for (auto cpu : cpus) {
+        if (cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+    }
+
+    return ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+/*static*/ auto Topology::ThreadAffinity() -> std::vector<uint32_t>
+{
+    auto cpus = std::vector<uint32_t>{};
+
+#if defined(__linux__)
+    auto set = cpu_set_t{};
+
+    if (::sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (auto cpu = uint32_t{ 0 }; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set))
+                cpus.push_back(cpu);
+        }
+    }
+#endif
+
+    if (cpus.empty()) {
+        for (auto cpu = uint32_t{ 0 }; cpu < std::max(std::thread::hardware_concurrency(), 1u); cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+
+    return cpus;
+}
+}
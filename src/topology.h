@@ -0,0 +1,57 @@
+//
+// Created by anton on 10/18/26.
+//
+
+#ifndef TASKWEAVER_TOPOLOGY_H
+#define TASKWEAVER_TOPOLOGY_H
+
+#include "common.h"
+#include <string_view>
+
+namespace taskweaver {
+// a logical cpu and the groups it belongs to, a group is named by its lowest cpu,
+// so cpus with the same l2 share the l2 cache and so on
+struct cpu_info_t
+{
+    uint32_t cpu;
+    uint32_t core;
+    uint32_t l2;
+    uint32_t l3;
+    uint32_t node;
+    uint32_t package;
+};
+
+// cpus the executors are placed on: physical cores first, grouped by package, numa node, l3 and l2,
+// so consecutive executors share caches and hyper-thread siblings are taken once all the cores are busy
+class Topology
+{
+public:
+    explicit Topology(std::vector<cpu_info_t> cpus);
+
+    // the cpus the process is allowed to run on (that includes cgroup cpuset restrictions),
+    // restricted further by the cpuset if it is not empty, read from /sys/devices/system/cpu on linux,
+    // elsewhere the cpus are assumed to share everything
+    static auto Detect(std::vector<uint32_t> const& cpuset = {}) -> Topology;
+
+    [[nodiscard]] auto Cpus() const -> std::vector<cpu_info_t> const& { return cpus_; }
+
+    [[nodiscard]] auto CpuCount() const -> size_t { return cpus_.size(); }
+
+    // the cpu of the executor, executors wrap around when there are more of them than cpus
+    [[nodiscard]] auto Placement(size_t executor) const -> cpu_info_t const& { return cpus_[executor % cpus_.size()]; }
+
+    // "0-3,8,10-11" format of sysfs and cgroups
+    static auto ParseCpuList(std::string_view list) -> std::vector<uint32_t>;
+
+    // binds the calling thread to the cpus, returns false if the system does not allow it
+    static auto PinThread(std::vector<uint32_t> const& cpus) -> bool;
+
+    // the cpus the calling thread may run on
+    static auto ThreadAffinity() -> std::vector<uint32_t>;
+
+private:
+    std::vector<cpu_info_t> cpus_;
+};
+}
+
+#endif // TASKWEAVER_TOPOLOGY_H
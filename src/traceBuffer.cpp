@@ -0,0 +1,112 @@
+//
+// Created by anton on 10/18/26.
+//
+
+#include "traceBuffer.h"
+#include <algorithm>
+#include <bit>
+#include <ostream>
+
+namespace taskweaver {
+namespace {
+auto event_name(trace_event_t const& event) -> char const*
+{
+    switch (event.type) {
+        case TraceEventType::Task:
+            return event.tag != nullptr ? event.tag : "task";
+        case TraceEventType::Steal:
+            return "steal";
+        case TraceEventType::Park:
+            return "park";
+    }
+
+    return "unknown";
+}
+
+// tags are written by hand, still they must not break the json
+void write_string(std::ostream& out, char const* s)
+{
+    out << '"';
+
+    for (; *s != '\0'; s++) {
+        if (*s == '"' || *s == '\\') {
+            out << '\\' << *s;
+        } else if (static_cast<unsigned char>(*s) >= 0x20) {
+            out << *s;
+        }
+    }
+
+    out << '"';
+}
+
+// microseconds with the nanosecond fraction
+void write_time(std::ostream& out, int64_t ns)
+{
+    auto fraction = ns % 1000;
+
+    out << ns / 1000 << '.' << static_cast<char>('0' + fraction / 100) << static_cast<char>('0' + fraction / 10 % 10)
+        << static_cast<char>('0' + fraction % 10);
+}
+}
+
+TraceBuffer::TraceBuffer(size_t capacity)
+  : mask_{ std::bit_ceil(std::max(capacity, size_t{ 1 })) - 1 }
+  , events_{ make_unique_for_overwrite<trace_event_t[]>(mask_ + 1) }
+  , head_{ 0 }
+{
+}
+
+auto TraceBuffer::Events() const -> std::vector<trace_event_t>
+{
+    auto head = head_.load(std::memory_order_acquire);
+    auto count = std::min(head, static_cast<uint64_t>(mask_ + 1));
+
+    auto events = std::vector<trace_event_t>{};
+    events.reserve(static_cast<size_t>(count));
+
+    for (auto i = head - count; i != head; i++) {
+        events.push_back(events_[i & mask_]);
+    }
+
+    return events;
+}
+
+/*static*/ void TraceBuffer::WriteChromeTrace(std::ostream& out, std::vector<TraceBuffer const*> const& buffers)
+{
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+    auto first = true;
+    auto separate = [&out, &first]() -> void {
+        out << (first ? "\n" : ",\n");
+        first = false;
+    };
+
+    for (auto tid = size_t{ 0 }; tid < buffers.size(); tid++) {
+        separate();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+            << ",\"args\":{\"name\":\"executor " << tid << "\"}}";
+
+        if (buffers[tid] == nullptr)
+            continue;
+
+        for (auto const& event : buffers[tid]->Events()) {
+            separate();
+            out << "{\"name\":";
+            write_string(out, event_name(event));
+            out << ",\"cat\":\"" << (event.type == TraceEventType::Task ? "task" : "scheduler") << "\",\"pid\":1,\"tid\":"
+                << tid << ",\"ts\":";
+            write_time(out, event.begin);
+
+            if (event.type == TraceEventType::Steal) {
+                out << ",\"ph\":\"i\",\"s\":\"t\",\"args\":{\"victim\":" << event.arg << "}}";
+            } else {
+                out << ",\"ph\":\"X\",\"dur\":";
+                write_time(out, event.end - event.begin);
+                out << "}";
+            }
+        }
+    }
+
+    out << "\n]}\n";
+}
+}
@@ -0,0 +1,76 @@
+//
+// Created by anton on 10/18/26.
+//
+
+#ifndef TASKWEAVER_TRACEBUFFER_H
+#define TASKWEAVER_TRACEBUFFER_H
+
+#include "common.h"
+#include <iosfwd>
+
+namespace taskweaver {
+enum class TraceEventType : uint32_t
+{
+    Task,  // a task run, nested ones go inside the task which waits for them
+    Steal, // a successful steal, the argument is the victim executor
+    Park,  // the executor sleeps
+};
+
+// nanoseconds since the start of the task manager, the tag is a string literal or nullptr
+struct trace_event_t
+{
+    int64_t begin;
+    int64_t end;
+    char const* tag;
+    TraceEventType type;
+    uint32_t arg;
+};
+
+// ring of the latest events of an executor, the owner thread writes without locks and overwrites the oldest events,
+// the events are read once the tracing is stopped
+class TraceBuffer
+{
+public:
+    TraceBuffer()
+      : mask_{ 0 }
+      , events_{}
+      , head_{ 0 }
+    {
+    }
+
+    // the capacity is rounded up to a power of two
+    explicit TraceBuffer(size_t capacity);
+
+    TraceBuffer(TraceBuffer const&) = delete;
+
+    TraceBuffer(TraceBuffer&&) = delete;
+
+    ~TraceBuffer() = default;
+
+    auto operator=(TraceBuffer const&) -> TraceBuffer& = delete;
+
+    auto operator=(TraceBuffer&&) -> TraceBuffer& = delete;
+
+    // can be called in owner thread only
+    void Record(trace_event_t const& event)
+    {
+        auto head = head_.load(std::memory_order_relaxed);
+        events_[head & mask_] = event;
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    // the recorded events, the oldest first
+    [[nodiscard]] auto Events() const -> std::vector<trace_event_t>;
+
+    // Chrome trace event format, viewable in Perfetto and chrome://tracing,
+    // every buffer is a thread named by its index
+    static void WriteChromeTrace(std::ostream& out, std::vector<TraceBuffer const*> const& buffers);
+
+private:
+    size_t mask_;
+    std::unique_ptr<trace_event_t[]> events_;
+    std::atomic<uint64_t> head_;
+};
+}
+
+#endif // TASKWEAVER_TRACEBUFFER_H
@@ -9,6 +9,8 @@
 #include "taskManager.h"
 #include <metrix/containers.h>
 #include <metrix/type_traits.h>
+#include <array>
+#include <stop_token>
 #include <tuple>
 
 namespace taskweaver {
@@ -27,210 +29,322 @@ template<typename F>
 struct get_future_type;
 
 template<typename T>
-struct get_future_type<std::future<T>>
+struct get_future_type<Future<T>>
 {
     using type_t = T;
 };
 
 template<>
-struct get_future_type<std::future<void>>
+struct get_future_type<Future<void>>
 {
     using type_t = void_future_result_t;
 };
 
-template<typename R>
-auto get_one_future_result(std::future<R>&& f) -> std::conditional_t<std::is_same_v<void, R>, void_future_result_t, R>
+template<typename F>
+auto get_one_future_result(F&& f) -> typename get_future_type<std::decay_t<F>>::type_t
 {
-    if constexpr (std::is_same_v<R, void>) {
+    if constexpr (std::is_same_v<void, decltype(f.get())>) {
         f.get();
         return void_future_result_t{};
     } else {
         return f.get();
     }
 }
-
-template<typename R>
-auto try_get_one_future_result(std::future<R>&& f)
-  -> std::optional<std::conditional_t<std::is_same_v<void, R>, void_future_result_t, R>>
-{
-    auto r = std::optional<std::conditional_t<std::is_same_v<void, R>, void_future_result_t, R>>{};
-
-    if (f.wait_for(std::chrono::microseconds{ 10 }) == std::future_status::ready) {
-        r = internal::get_one_future_result(std::move(f));
-    }
-
-    return r;
-}
 } // internal
 
+// only own futures are supported: std::future has no completion hook
+// and can't be combined without a blocked or polling thread
 template<typename F>
-concept FutureConcept = metrix::is_specialization_of_v<F, std::future>;
+concept FutureConcept = metrix::is_specialization_of_v<F, Future>;
 
 template<typename C>
 concept FutureContainerConcept =
-  metrix::is_iterable_v<C> && metrix::is_specialization_of_v<typename C::value_type, std::future>;
+  metrix::is_iterable_v<std::remove_cvref_t<C>> && FutureConcept<typename std::remove_cvref_t<C>::value_type>;
 
 template<typename I>
 concept FutureInteratorConcept =
-  std::input_iterator<I> && metrix::is_specialization_of_v<typename std::iterator_traits<I>::value_type, std::future>;
+  std::input_iterator<I> && FutureConcept<typename std::iterator_traits<I>::value_type>;
 
 template<FutureConcept F>
 using future_type_t = typename internal::get_future_type<F>::type_t;
 
-template<FutureConcept... F>
-auto when_all(F&&... f) -> std::future<std::tuple<future_type_t<F>...>>
+namespace internal {
+template<typename Node, typename... T>
+auto make_continuation_nodes(std::tuple<Future<T>...> const&) -> std::array<Node, sizeof...(T)>
 {
-    auto promise = std::promise<std::tuple<future_type_t<F>...>>{};
-    auto future = promise.get_future();
-    auto futures = std::make_tuple(std::move(f)...);
+    return std::array<Node, sizeof...(T)>{};
+}
 
-    Executor::ThreadExecutor().SubmitTask([p = std::move(promise), fs = std::move(futures)]() mutable -> void {
-        []<size_t... I>(std::index_sequence<I...>, auto&& futures, auto&& promise)->void
-        {
-            promise.set_value(std::make_tuple(internal::get_one_future_result(std::move(std::get<I>(futures)))...));
-        }
-        (std::make_index_sequence<std::tuple_size_v<decltype(fs)>>{}, std::move(fs), std::move(p));
-    });
+// the nodes live as long as the combinator state, so they come from the same slab
+template<typename Node, typename T>
+auto make_continuation_nodes(std::vector<Future<T>> const& futures) -> std::pmr::vector<Node>
+{
+    return std::pmr::vector<Node>(futures.size(), SlabAllocator::ThreadResource());
+}
 
-    return future;
+template<typename... T, typename F>
+void for_each_future(std::tuple<Future<T>...>& futures, F&& f)
+{
+    [&]<size_t... I>(std::index_sequence<I...>)->void { (f(I, std::get<I>(futures)), ...); }
+    (std::index_sequence_for<T...>{});
 }
 
-template<FutureContainerConcept C>
-auto when_all(C const& container) -> std::future<std::vector<future_type_t<typename C::value_type>>>
+template<typename T, typename F>
+void for_each_future(std::vector<Future<T>>& futures, F&& f)
 {
-    auto v = std::vector<future_type_t<typename C::value_type>>{};
-    v.reserve(std::size(container));
+    for (auto i = size_t{ 0 }; i < futures.size(); i++) {
+        f(i, futures[i]);
+    }
+}
 
-    auto promise = std::promise<decltype(v)>{};
-    auto future = promise.get_future();
+template<typename... T>
+auto take_all_results(std::tuple<Future<T>...>& futures) -> std::tuple<future_type_t<Future<T>>...>
+{
+    return [&]<size_t... I>(std::index_sequence<I...>)->std::tuple<future_type_t<Future<T>>...>
+    {
+        return std::tuple<future_type_t<Future<T>>...>{ get_one_future_result(std::get<I>(futures))... };
+    }
+    (std::index_sequence_for<T...>{});
+}
 
-    Executor::ThreadExecutor().SubmitTask([&container, v = std::move(v), p = std::move(promise)]() mutable -> void {
-        for (auto&& f : container) {
-            v.emplace_back(internal::get_one_future_result(f));
-        }
-        p.set_value(v);
-    });
+template<typename T>
+auto take_all_results(std::vector<Future<T>>& futures) -> std::vector<future_type_t<Future<T>>>
+{
+    auto v = std::vector<future_type_t<Future<T>>>{};
+    v.reserve(futures.size());
 
-    return future;
+    for (auto& f : futures) {
+        v.emplace_back(get_one_future_result(f));
+    }
+
+    return v;
 }
 
-template<FutureInteratorConcept InputIt>
-auto when_all(InputIt first, InputIt last)
-  -> std::future<std::vector<future_type_t<typename std::iterator_traits<InputIt>::value_type>>>
+template<typename... T>
+auto take_any_result(std::tuple<Future<T>...>& futures, size_t index)
+  -> when_any_result_t<std::tuple<future_type_t<Future<T>>...>>
 {
-    auto v = std::vector<future_type_t<typename std::iterator_traits<InputIt>::value_type>>{};
-    v.reserve(std::distance(first, last));
+    auto r = when_any_result_t<std::tuple<future_type_t<Future<T>>...>>{};
+    r.index = index;
 
-    auto promise = std::promise<decltype(v)>{};
-    auto future = promise.get_future();
+    [&]<size_t... I>(std::index_sequence<I...>)->void
+    {
+        ((I == index ? void(std::get<I>(r.result) = get_one_future_result(std::get<I>(futures))) : void()), ...);
+    }
+    (std::index_sequence_for<T...>{});
 
-    Executor::ThreadExecutor().SubmitTask([first, last, v = std::move(v), p = std::move(promise)]() mutable -> void {
-        for (auto it = first; it != last; it++) {
-            v.emplace_back(internal::get_one_future_result(*it));
-        }
-        p.set_value(v);
-    });
+    return r;
+}
 
-    return future;
+template<typename T>
+auto take_any_result(std::vector<Future<T>>& futures, size_t index) -> when_any_result_t<future_type_t<Future<T>>>
+{
+    return when_any_result_t<future_type_t<Future<T>>>{ get_one_future_result(futures[index]), index };
 }
 
-namespace internal {
-template<size_t I, typename ResultTuple, typename F, typename... Futures>
-auto set_when_any_result(when_any_result_t<ResultTuple>& result, F&& future, Futures&&... futures) -> bool
+// shared state of a combinator: owns the input futures, is driven by their continuations
+// and destroys itself on the thread which completes the last of them,
+// so no thread is blocked or polls the inputs
+template<typename Futures, typename Result, typename Derived>
+struct combinator_state_t
+{
+    struct node_t : future_continuation_t
+    {
+        combinator_state_t* owner;
+        size_t index;
+    };
+
+    explicit combinator_state_t(Futures&& futures)
+      : futures_{ std::move(futures) }
+      , nodes_{ make_continuation_nodes<node_t>(futures_) }
+      , pending_{ 1 }
+      , promise_{}
+    {
+    }
+
+    // the state may be destroyed before the call returns
+    void start()
+    {
+        for_each_future(futures_, [this](size_t index, auto& future) -> void {
+            assert(future.valid());
+
+            pending_.fetch_add(1, std::memory_order_relaxed);
+
+            auto& node = nodes_[index];
+            node.invoke = &on_ready;
+            node.owner = this;
+            node.index = index;
+
+            future.set_continuation(node);
+        });
+
+        // the continuations of ready futures run immediately, so the extra count
+        // keeps the state alive until all of them are attached
+        release();
+    }
+
+    static void on_ready(future_continuation_t* continuation)
+    {
+        auto& node = *static_cast<node_t*>(continuation);
+        auto* owner = node.owner;
+
+        static_cast<Derived*>(owner)->ready(node.index);
+        owner->release();
+    }
+
+    void release()
+    {
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            static_cast<Derived*>(this)->finish();
+            destroy_state(static_cast<Derived*>(this));
+        }
+    }
+
+    Futures futures_;
+    decltype(make_continuation_nodes<node_t>(std::declval<Futures const&>())) nodes_;
+    std::atomic<size_t> pending_;
+    Promise<Result> promise_;
+};
+
+// the result is set by the thread which completes the last input
+template<typename Futures>
+struct when_all_state_t
+  : combinator_state_t<Futures,
+                       decltype(take_all_results(std::declval<Futures&>())),
+                       when_all_state_t<Futures>>
 {
-    auto&& v = internal::try_get_one_future_result(std::move(future));
-    if (v.has_value()) {
-        std::get<I>(result.result) = std::move(v.value());
-        result.index = I;
+    using when_all_state_t::combinator_state_t::combinator_state_t;
+
+    void ready(size_t) {}
 
-        return true;
+    void finish()
+    {
+        this->promise_.set_result_of([this]() -> auto { return take_all_results(this->futures_); });
+    }
+};
+
+// the result is set by the thread which completes the first input,
+// the others just release the state,
+// empty input results in broken promise,
+// the stop source, if any, is triggered by the winner so the losers are skipped or stop early
+template<typename Futures>
+struct when_any_state_t
+  : combinator_state_t<Futures,
+                       decltype(take_any_result(std::declval<Futures&>(), size_t{})),
+                       when_any_state_t<Futures>>
+{
+    explicit when_any_state_t(Futures&& futures, std::stop_source stop = std::stop_source{ std::nostopstate })
+      : when_any_state_t::combinator_state_t{ std::move(futures) }
+      , won_{ false }
+      , stop_{ std::move(stop) }
+    {
+    }
+
+    void ready(size_t index)
+    {
+        if (!won_.exchange(true, std::memory_order_relaxed)) {
+            stop_.request_stop();
+            this->promise_.set_result_of([this, index]() -> auto { return take_any_result(this->futures_, index); });
+        }
     }
 
-    if constexpr (sizeof...(futures) > 0) {
-        set_when_any_result<I + 1>(result, std::move(futures)...);
+    void finish() {}
+
+    std::atomic<bool> won_;
+    std::stop_source stop_;
+};
+
+template<typename State, typename Futures, typename... Args>
+auto start_combinator(Futures&& futures, Args&&... args)
+{
+    auto* state = create_state<State>(std::move(futures), std::forward<Args>(args)...);
+    auto future = state->promise_.get_future();
+
+    state->start();
+
+    return future;
+}
+
+template<typename InputIt>
+auto move_futures(InputIt first, InputIt last) -> std::vector<typename std::iterator_traits<InputIt>::value_type>
+{
+    auto futures = std::vector<typename std::iterator_traits<InputIt>::value_type>{};
+
+    for (auto it = first; it != last; it++) {
+        futures.emplace_back(std::move(*it));
     }
 
-    return false;
+    return futures;
 }
 } // internal
 
 template<FutureConcept... F>
-auto when_any(F&&... f) -> std::future<when_any_result_t<std::tuple<future_type_t<F>...>>>
-{
-    auto result = when_any_result_t<std::tuple<future_type_t<F>...>>{};
-    auto promise = std::promise<when_any_result_t<std::tuple<future_type_t<F>...>>>{};
-    auto future = promise.get_future();
-    auto futures = std::make_tuple(std::move(f)...);
-
-    Executor::ThreadExecutor().SubmitTask(
-      [r = std::move(result), p = std::move(promise), fs = std::move(futures)]() mutable -> void {
-          []<size_t... I>(std::index_sequence<I...>, auto& result, auto&& futures, auto&& promise)->void
-          {
-              while (!internal::set_when_any_result<0>(result, std::move(std::get<I>(futures))...)) {
-              }
-              promise.set_value(std::move(result));
-          }
-          (std::make_index_sequence<std::tuple_size_v<decltype(fs)>>{}, r, std::move(fs), std::move(p));
-      });
+auto when_all(F&&... f) -> Future<std::tuple<future_type_t<F>...>>
+{
+    using state_t = internal::when_all_state_t<std::tuple<F...>>;
+    return internal::start_combinator<state_t>(std::tuple<F...>{ std::move(f)... });
+}
 
-    return future;
+template<FutureInteratorConcept InputIt>
+auto when_all(InputIt first, InputIt last)
+  -> Future<std::vector<future_type_t<typename std::iterator_traits<InputIt>::value_type>>>
+{
+    auto futures = internal::move_futures(first, last);
+    return internal::start_combinator<internal::when_all_state_t<decltype(futures)>>(std::move(futures));
 }
 
+// futures are moved out of the container
 template<FutureContainerConcept C>
-auto when_any(C const& container) -> std::future<when_any_result_t<future_type_t<typename C::value_type>>>
-{
-    auto result = when_any_result_t<future_type_t<typename C::value_type>>{};
-    auto promise = std::promise<when_any_result_t<future_type_t<typename C::value_type>>>{};
-    auto future = promise.get_future();
-
-    Executor::ThreadExecutor().SubmitTask(
-      [&container, r = std::move(result), p = std::move(promise)]() mutable -> void {
-          auto any_result = false;
-          while (!any_result) {
-              auto i = size_t{ 0 };
-              for (auto&& f : container) {
-                  if (auto opt = internal::try_get_one_future_result(std::move(f)); opt.has_value()) {
-                      r.result = opt.value();
-                      r.index = i;
-                      any_result = true;
-                      break;
-                  }
-                  i++;
-              }
-          }
-          p.set_value(std::move(r));
-      });
+auto when_all(C&& container) -> Future<std::vector<future_type_t<typename std::remove_cvref_t<C>::value_type>>>
+{
+    return when_all(std::begin(container), std::end(container));
+}
 
-    return future;
+template<FutureConcept... F>
+auto when_any(F&&... f) -> Future<when_any_result_t<std::tuple<future_type_t<F>...>>>
+{
+    using state_t = internal::when_any_state_t<std::tuple<F...>>;
+    return internal::start_combinator<state_t>(std::tuple<F...>{ std::move(f)... });
 }
 
 template<FutureInteratorConcept InputIt>
 auto when_any(InputIt first, InputIt last)
-  -> std::future<when_any_result_t<future_type_t<typename std::iterator_traits<InputIt>::value_type>>>
-{
-    auto result = when_any_result_t<future_type_t<typename std::iterator_traits<InputIt>::value_type>>{};
-    auto promise = std::promise<when_any_result_t<future_type_t<typename std::iterator_traits<InputIt>::value_type>>>{};
-    auto future = promise.get_future();
-
-    Executor::ThreadExecutor().SubmitTask(
-      [first, last, r = std::move(result), p = std::move(promise)]() mutable -> void {
-          auto any_result = false;
-          while (!any_result) {
-              auto i = size_t{ 0 };
-              for (auto it = first; it != last; it++) {
-                  if (auto opt = internal::try_get_one_future_result(std::move(*it)); opt.has_value()) {
-                      r.result = opt.value();
-                      r.index = i;
-                      any_result = true;
-                      break;
-                  }
-                  i++;
-              }
-          }
-          p.set_value(std::move(r));
-      });
+  -> Future<when_any_result_t<future_type_t<typename std::iterator_traits<InputIt>::value_type>>>
+{
+    auto futures = internal::move_futures(first, last);
+    return internal::start_combinator<internal::when_any_state_t<decltype(futures)>>(std::move(futures));
+}
 
-    return future;
+// futures are moved out of the container
+template<FutureContainerConcept C>
+auto when_any(C&& container) -> Future<when_any_result_t<future_type_t<typename std::remove_cvref_t<C>::value_type>>>
+{
+    return when_any(std::begin(container), std::end(container));
+}
+
+// the stop is requested once the first input is ready, the inputs are expected to be tasks
+// submitted with tokens of the source, so the losers do not keep the executors busy
+template<FutureConcept... F>
+auto when_any(std::stop_source stop, F&&... f) -> Future<when_any_result_t<std::tuple<future_type_t<F>...>>>
+{
+    using state_t = internal::when_any_state_t<std::tuple<F...>>;
+    return internal::start_combinator<state_t>(std::tuple<F...>{ std::move(f)... }, std::move(stop));
+}
+
+template<FutureInteratorConcept InputIt>
+auto when_any(std::stop_source stop, InputIt first, InputIt last)
+  -> Future<when_any_result_t<future_type_t<typename std::iterator_traits<InputIt>::value_type>>>
+{
+    auto futures = internal::move_futures(first, last);
+    return internal::start_combinator<internal::when_any_state_t<decltype(futures)>>(std::move(futures),
+                                                                                     std::move(stop));
+}
+
+template<FutureContainerConcept C>
+auto when_any(std::stop_source stop, C&& container)
+  -> Future<when_any_result_t<future_type_t<typename std::remove_cvref_t<C>::value_type>>>
+{
+    return when_any(std::move(stop), std::begin(container), std::end(container));
 }
 }
 
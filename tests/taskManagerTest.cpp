@@ -3,8 +3,14 @@
 //
 
 #include "taskManagerTest.h"
+#include "../src/asyncTask.h"
+#include "../src/parallel.h"
+#include "../src/taskGraph.h"
 #include "../src/utility.h"
 #include <cmath>
+#include <latch>
+#include <numeric>
+#include <sstream>
 
 namespace {
 struct alignas(hardware_constructive_interference_size) data_item_t
@@ -37,6 +43,26 @@ void tuple_to_array(Tuple&& src, std::array<data_item_t, N>& dst, std::index_seq
 {
     ((dst[I] = std::get<I>(src)), ...);
 }
+
+auto recursive_sum(uint64_t begin, uint64_t end) -> uint64_t
+{
+    if (end - begin <= 16) {
+        auto sum = uint64_t{ 0 };
+
+        for (auto i = begin; i < end; i++)
+            sum += i;
+
+        return sum;
+    }
+
+    auto middle = begin + (end - begin) / 2;
+    auto left =
+      taskweaver::TaskManager::SubmitTask([begin, middle]() -> uint64_t { return recursive_sum(begin, middle); });
+    auto right = recursive_sum(middle, end);
+
+    // waits inside of a task, executor helps with pending tasks instead of blocking
+    return left.get() + right;
+}
 }
 
 void parrallelComputationWhenAllTest()
@@ -98,6 +124,967 @@ void whenAnyTest() {
     EXPECT_TRUE(b);
 }
 
+void wakeUpAfterIdleTest()
+{
+    // executors have enough time to park
+    std::this_thread::sleep_for(std::chrono::milliseconds{ 100 });
+
+    auto futures = std::array{ taskweaver::TaskManager::SubmitTask([]() -> uint32_t { return 1; }),
+                               taskweaver::TaskManager::SubmitTask([]() -> uint32_t { return 2; }) };
+
+    auto res = taskweaver::when_all(std::move(futures[0]), std::move(futures[1])).get();
+
+    EXPECT_EQ(std::get<0>(res) + std::get<1>(res), 3u);
+}
+
+void postFromExternalThreadTest(taskweaver::TaskManager& taskManager)
+{
+    constexpr auto taskCount = uint32_t{ 10000 };
+
+    auto sum = uint64_t{ 0 };
+
+    // the thread owns no executor
+    auto producer = std::thread([&taskManager, &sum]() -> void {
+        auto futures = std::vector<taskweaver::Future<uint32_t>>{};
+        futures.reserve(taskCount);
+
+        for (auto i = uint32_t{ 0 }; i < taskCount; i++) {
+            futures.push_back(taskManager.Post([i]() -> uint32_t { return i; }));
+        }
+
+        for (auto&& f : futures) {
+            sum += f.get();
+        }
+    });
+
+    producer.join();
+
+    EXPECT_EQ(sum, uint64_t{ taskCount } * (taskCount - 1) / 2);
+}
+
+void postToFullQueueTest()
+{
+    std::thread{ []() -> void {
+        constexpr auto taskCount = uint32_t{ 64 };
+        constexpr auto queueSize = uint32_t{ 4 };
+
+        auto taskManager = taskweaver::TaskManager{ taskweaver::task_manager_options_t{
+          .injectionQueueSize = queueSize, .threadPoolSize = 1 } };
+
+        auto posted = std::atomic<uint32_t>{ 0 };
+        auto sum = uint64_t{ 0 };
+
+        // nothing takes the tasks before the start, so the producer sleeps on the full queue
+        auto producer = std::thread{ [&taskManager, &posted, &sum]() -> void {
+            auto futures = std::vector<taskweaver::Future<uint32_t>>{};
+
+            for (auto i = uint32_t{ 0 }; i < taskCount; i++) {
+                futures.push_back(taskManager.Post([i]() -> uint32_t { return i; }));
+                posted++;
+            }
+
+            for (auto&& f : futures) {
+                sum += f.get();
+            }
+        } };
+
+        while (posted.load() < queueSize)
+            std::this_thread::yield();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds{ 20 });
+        EXPECT_EQ(posted.load(), queueSize);
+
+        taskManager.Start();
+        producer.join();
+
+        EXPECT_EQ(sum, uint64_t{ taskCount } * (taskCount - 1) / 2);
+#if defined(TASKWEAVER_STATISTICS)
+        EXPECT_GE(taskManager.Stats().injectionStalls, uint64_t{ 1 });
+#endif
+
+        taskManager.Stop();
+
+        // a stopped task manager runs the task in the posting thread
+        std::thread{ [&taskManager]() -> void {
+            auto id = taskManager.Post([]() -> std::thread::id { return std::this_thread::get_id(); });
+
+            ASSERT_TRUE(id.is_ready());
+            EXPECT_EQ(id.get(), std::this_thread::get_id());
+        } }.join();
+    } }.join();
+}
+
+void futureExceptionTest()
+{
+    auto future = taskweaver::TaskManager::SubmitTask([]() -> uint32_t { throw std::runtime_error{ "task error" }; });
+
+    EXPECT_THROW(future.get(), std::runtime_error);
+    EXPECT_FALSE(future.valid());
+
+    auto broken = taskweaver::Future<void>{};
+    {
+        auto promise = taskweaver::Promise<void>{};
+        broken = promise.get_future();
+    }
+
+    EXPECT_TRUE(broken.is_ready());
+    EXPECT_THROW(broken.get(), std::future_error);
+}
+
+void dispatchTest()
+{
+    constexpr auto taskCount = ptrdiff_t{ 1000 };
+
+    auto done = std::latch{ taskCount };
+    auto sum = std::atomic<uint64_t>{ 0 };
+
+    for (auto i = ptrdiff_t{ 0 }; i < taskCount; i++) {
+        taskweaver::TaskManager::Dispatch([i, &done, &sum]() -> void {
+            sum.fetch_add(static_cast<uint64_t>(i), std::memory_order_relaxed);
+            done.count_down();
+        });
+    }
+
+    done.wait();
+
+    EXPECT_EQ(sum.load(), uint64_t{ taskCount * (taskCount - 1) / 2 });
+}
+
+void combinatorsTest()
+{
+    // container of ready futures completes immediately in the calling thread
+    auto ready = std::vector<taskweaver::Future<uint32_t>>{};
+    for (auto i = uint32_t{ 0 }; i < 4; i++) {
+        auto promise = taskweaver::Promise<uint32_t>{};
+        ready.push_back(promise.get_future());
+        promise.set_value(i);
+    }
+
+    auto all = taskweaver::when_all(ready);
+    ASSERT_TRUE(all.is_ready());
+    EXPECT_EQ(all.get(), (std::vector<uint32_t>{ 0, 1, 2, 3 }));
+
+    // the first completed input wins
+    auto first = taskweaver::Promise<uint32_t>{};
+    auto second = taskweaver::Promise<uint32_t>{};
+    auto any = taskweaver::when_any(first.get_future(), second.get_future());
+
+    EXPECT_FALSE(any.is_ready());
+    second.set_value(7);
+
+    auto res = any.get();
+    EXPECT_EQ(res.index, 1u);
+    EXPECT_EQ(std::get<1>(res.result), 7u);
+    first.set_value(0);
+
+    // an exception of any input is propagated
+    auto failed = taskweaver::when_all(
+      taskweaver::TaskManager::SubmitTask([]() -> uint32_t { return 1; }),
+      taskweaver::TaskManager::SubmitTask([]() -> uint32_t { throw std::runtime_error{ "task error" }; }));
+
+    EXPECT_THROW(failed.get(), std::runtime_error);
+}
+
+void thenTest()
+{
+    // pipeline of continuations, nobody waits until the end
+    auto chained = taskweaver::TaskManager::SubmitTask([]() -> uint32_t { return 1; })
+                     .then([](uint32_t v) -> uint32_t { return v + 1; })
+                     .then([](uint32_t v) -> void { EXPECT_EQ(v, 2u); })
+                     .then([]() -> uint32_t { return 3; });
+
+    EXPECT_EQ(chained.get(), 3u);
+
+    auto combined = taskweaver::when_all(taskweaver::TaskManager::SubmitTask([]() -> uint32_t { return 1; }),
+                                         taskweaver::TaskManager::SubmitTask([]() -> uint32_t { return 2; }))
+                      .then([](std::tuple<uint32_t, uint32_t> v) -> uint32_t {
+                          return std::get<0>(v) + std::get<1>(v);
+                      });
+
+    EXPECT_EQ(combined.get(), 3u);
+
+    // exception skips the continuation
+    auto called = false;
+    auto failed = taskweaver::TaskManager::SubmitTask([]() -> uint32_t { throw std::runtime_error{ "task error" }; })
+                    .then([&called](uint32_t v) -> uint32_t {
+                        called = true;
+                        return v;
+                    });
+
+    EXPECT_THROW(failed.get(), std::runtime_error);
+    EXPECT_FALSE(called);
+
+    // the promise is satisfied by a thread without executor,
+    // the continuation goes to the task manager of the thread which has attached it
+    auto promise = taskweaver::Promise<uint32_t>{};
+    auto posted = promise.get_future().then([](uint32_t v) -> uint32_t { return v * 2; });
+
+    std::thread{ [&promise]() -> void { promise.set_value(21); } }.join();
+
+    EXPECT_EQ(posted.get(), 42u);
+}
+
+void thenAfterStopTest()
+{
+    // a continuation queued right before the task manager stops is not lost, it runs when the task manager is destroyed
+    auto ran = std::atomic<bool>{ false };
+
+    std::thread{ [&ran]() -> void {
+        auto taskManager = taskweaver::TaskManager{ taskweaver::task_manager_options_t{ .threadPoolSize = 1 } };
+        taskManager.Start();
+
+        auto queued = std::atomic<bool>{ false };
+        auto promise = taskweaver::Promise<void>{};
+        auto chained = promise.get_future().then([&ran]() -> void { ran = true; });
+
+        // the only worker queues the continuation and keeps busy until the stop
+        auto worker = taskManager.Post([&taskManager, &promise, &queued]() -> void {
+            promise.set_value();
+            queued = true;
+
+            while (taskManager.KeepAlive())
+                std::this_thread::yield();
+        });
+
+        while (!queued)
+            std::this_thread::yield();
+
+        taskManager.Stop();
+
+        EXPECT_FALSE(ran.load());
+        EXPECT_TRUE(worker.is_ready());
+    } }.join();
+
+    EXPECT_TRUE(ran.load());
+}
+
+void taskGraphTest()
+{
+    constexpr auto width = size_t{ 64 };
+    constexpr auto runs = size_t{ 3 };
+
+    // layers of the prefix sum scan as a graph: every element of a step depends on two elements of the previous one,
+    // no waiting between the steps
+    auto src = std::array<uint32_t, width>{};
+    auto dst = std::array<uint32_t, width>{};
+    auto steps = static_cast<size_t>(std::log2(width));
+    auto layers = std::vector<std::array<uint32_t, width>>(steps + 1);
+
+    auto graph = taskweaver::TaskGraph{};
+    auto previous = std::vector<taskweaver::TaskGraph::node_id_t>{};
+
+    for (auto i = size_t{ 0 }; i < width; i++) {
+        previous.push_back(graph.Emplace([&layers, &src, i]() -> void { layers[0][i] = src[i]; }));
+    }
+
+    for (auto step = size_t{ 0 }; step < steps; step++) {
+        auto current = std::vector<taskweaver::TaskGraph::node_id_t>{};
+        auto sh = size_t{ 1 } << step;
+
+        for (auto i = size_t{ 0 }; i < width; i++) {
+            auto node = graph.Emplace([&layers, step, sh, i]() -> void {
+                layers[step + 1][i] = layers[step][i] + (i >= sh ? layers[step][i - sh] : 0);
+            });
+
+            graph.Precede(previous[i], node);
+            if (i >= sh)
+                graph.Precede(previous[i - sh], node);
+
+            current.push_back(node);
+        }
+
+        previous = std::move(current);
+    }
+
+    for (auto i = size_t{ 0 }; i < width; i++) {
+        graph.Precede(previous[i], graph.Emplace([&layers, &dst, steps, i]() -> void { dst[i] = layers[steps][i]; }));
+    }
+
+    // the same graph runs again with the other input
+    for (auto run = size_t{ 0 }; run < runs; run++) {
+        for (auto i = size_t{ 0 }; i < width; i++) {
+            src[i] = static_cast<uint32_t>(i + run);
+        }
+
+        graph.Run().get();
+
+        auto sum = uint32_t{ 0 };
+        for (auto i = size_t{ 0 }; i < width; i++) {
+            sum += src[i];
+            ASSERT_EQ(dst[i], sum);
+        }
+    }
+
+    // the exception of a node goes to the run result, the rest of the graph is completed
+    auto failing = taskweaver::TaskGraph{};
+    auto completed = std::atomic<uint32_t>{ 0 };
+
+    auto root = failing.Emplace([]() -> void { throw std::runtime_error{ "node error" }; });
+    failing.Precede(root, failing.Emplace([&completed]() -> void { completed++; }));
+    failing.Emplace([&completed]() -> void { completed++; });
+
+    EXPECT_THROW(failing.Run().get(), std::runtime_error);
+    EXPECT_EQ(completed.load(), 2u);
+}
+
+void taskGraphLifetimeTest()
+{
+    // an idle graph with a capture too large for the task is destroyed after its task manager
+    auto captures = std::make_shared<uint32_t>(0);
+    auto runs = std::atomic<uint32_t>{ 0 };
+
+    std::thread{ [&captures, &runs]() -> void {
+        auto graph = taskweaver::TaskGraph{};
+        auto taskManager = taskweaver::TaskManager{ taskweaver::task_manager_options_t{ .threadPoolSize = 2 } };
+        taskManager.Start();
+
+        taskManager
+          .Post([&graph, &captures, &runs]() -> void {
+              auto large = std::array<uint64_t, 16>{};
+
+              static_assert(!taskweaver::Task::is_inline_v<decltype([large, captures]() -> void {})>);
+
+              graph.Emplace([large, captures, &runs]() -> void { runs += 1 + static_cast<uint32_t>(large[0]); });
+              graph.Run().get();
+          })
+          .get();
+
+        taskManager.Stop();
+    } }.join();
+
+    EXPECT_EQ(runs.load(), 1u);
+    EXPECT_EQ(captures.use_count(), 1);
+}
+
+void parallelForTest()
+{
+    constexpr auto size = size_t{ 100000 };
+
+    auto values = std::vector<uint64_t>(size, 0);
+
+    taskweaver::parallel_for(size_t{ 0 }, size, [&values](size_t i) -> void { values[i] = i; });
+
+    for (auto i = size_t{ 0 }; i < size; i++) {
+        ASSERT_EQ(values[i], i);
+    }
+
+    // iterator range with explicit grain
+    taskweaver::parallel_for(values.begin(), values.end(), [](uint64_t& v) -> void { v *= 2; }, 16);
+
+    auto sum = taskweaver::parallel_reduce(
+      values.cbegin(), values.cend(), uint64_t{ 0 }, [](uint64_t a, uint64_t b) -> uint64_t { return a + b; });
+
+    EXPECT_EQ(sum, uint64_t{ size } * (size - 1));
+
+    auto max = taskweaver::parallel_reduce(
+      0, 1000, 0, [](int a, int b) -> int { return std::max(a, b); }, 1);
+
+    EXPECT_EQ(max, 999);
+
+    // empty range gives the identity
+    EXPECT_EQ(taskweaver::parallel_reduce(5, 5, 7, [](int a, int b) -> int { return a + b; }), 7);
+
+    auto throwing = [](int i) -> void {
+        if (i == 500)
+            throw std::runtime_error{ "body error" };
+    };
+
+    EXPECT_THROW(taskweaver::parallel_for(0, 1000, throwing), std::runtime_error);
+}
+
+void parallelAlgorithmsTest()
+{
+    // a few blocks with the incomplete last one
+    constexpr auto size = size_t{ 100003 };
+
+    auto values = std::vector<uint64_t>(size);
+    for (auto i = size_t{ 0 }; i < size; i++) {
+        values[i] = (i * 7919) % 1000;
+    }
+
+    auto expected = std::vector<uint64_t>(size);
+    auto scanned = std::vector<uint64_t>(size);
+
+    std::inclusive_scan(values.begin(), values.end(), expected.begin());
+    EXPECT_EQ(taskweaver::inclusive_scan(values.begin(), values.end(), scanned.begin()), scanned.end());
+    EXPECT_EQ(scanned, expected);
+
+    std::exclusive_scan(values.begin(), values.end(), expected.begin(), uint64_t{ 5 });
+    taskweaver::exclusive_scan(values.begin(), values.end(), scanned.begin(), uint64_t{ 5 });
+    EXPECT_EQ(scanned, expected);
+
+    // in place
+    scanned = values;
+    taskweaver::exclusive_scan(scanned.begin(), scanned.end(), scanned.begin(), uint64_t{ 5 });
+    EXPECT_EQ(scanned, expected);
+
+    auto sorted = values;
+    taskweaver::sort(sorted.begin(), sorted.end(), std::greater<>{});
+
+    std::sort(values.begin(), values.end(), std::greater<>{});
+    EXPECT_EQ(sorted, values);
+}
+
+auto asyncSum(uint32_t count) -> taskweaver::AsyncTask<uint64_t>
+{
+    auto sum = uint64_t{ 0 };
+
+    for (auto i = uint32_t{ 0 }; i < count; i++) {
+        // suspends until the task is done, the worker is free meanwhile
+        sum += co_await taskweaver::TaskManager::SubmitTask([i]() -> uint64_t { return i; });
+    }
+
+    co_return sum;
+}
+
+auto asyncPipeline(std::atomic<uint32_t>& hops) -> taskweaver::AsyncTask<uint64_t>
+{
+    co_await taskweaver::schedule();
+    hops++;
+
+    auto a = co_await asyncSum(100);
+    auto b = co_await asyncSum(10);
+
+    co_await taskweaver::schedule();
+    hops++;
+
+    co_return a + b;
+}
+
+auto asyncThrow() -> taskweaver::AsyncTask<>
+{
+    co_await taskweaver::TaskManager::SubmitTask([]() -> void { throw std::runtime_error{ "task error" }; });
+}
+
+void asyncTaskTest()
+{
+    auto hops = std::atomic<uint32_t>{ 0 };
+
+    EXPECT_EQ(taskweaver::Spawn(asyncPipeline(hops)).get(), uint64_t{ 100 * 99 / 2 + 10 * 9 / 2 });
+    EXPECT_EQ(hops.load(), 2u);
+
+    EXPECT_THROW(taskweaver::Spawn(asyncThrow()).get(), std::runtime_error);
+
+    // many coroutines suspended at the same time
+    auto futures = std::vector<taskweaver::Future<uint64_t>>{};
+    for (auto i = 0; i < 100; i++) {
+        futures.push_back(taskweaver::Spawn(asyncSum(10)));
+    }
+
+    for (auto& future : futures) {
+        EXPECT_EQ(future.get(), 45u);
+    }
+}
+
+void taskStorageTest()
+{
+    static_assert(sizeof(taskweaver::Task) == taskweaver::Task::size_v);
+
+    // small capture is kept in the task, large one goes to the executor slab
+    auto small = std::array<uint64_t, 2>{ 1, 2 };
+    auto large = std::array<uint64_t, 32>{};
+    std::iota(large.begin(), large.end(), uint64_t{ 0 });
+
+    static_assert(taskweaver::Task::is_inline_v<decltype([small]() -> void {})>);
+    static_assert(!taskweaver::Task::is_inline_v<decltype([large]() -> void {})>);
+
+    // captures are destroyed after the tasks have run
+    auto counter = std::make_shared<uint32_t>(0);
+
+    auto smallSum = taskweaver::TaskManager::SubmitTask([small, counter]() -> uint64_t { return small[0] + small[1]; });
+    auto largeSum = taskweaver::TaskManager::SubmitTask([large, counter]() -> uint64_t {
+        return std::accumulate(large.begin(), large.end(), uint64_t{ 0 });
+    });
+
+    EXPECT_EQ(smallSum.get(), 3u);
+    EXPECT_EQ(largeSum.get(), uint64_t{ 31 * 32 / 2 });
+
+    // the last task may still be releasing its slot
+    while (counter.use_count() > 1)
+        std::this_thread::yield();
+
+    // a throwing capture returns its slab block, the slab hands out the last released block first
+    struct throwing_t
+    {
+        throwing_t() = default;
+
+        throwing_t(throwing_t const&) { throw std::runtime_error{ "capture error" }; }
+
+        void operator()() const {}
+
+        std::array<uint64_t, 16> data{};
+    };
+
+    static_assert(!taskweaver::Task::is_inline_v<throwing_t>);
+
+    auto reused = taskweaver::TaskManager::SubmitTask([]() -> bool {
+        auto* block = taskweaver::SlabAllocator::ThreadAllocate(sizeof(throwing_t));
+        taskweaver::SlabAllocator::Deallocate(block);
+
+        auto capture = throwing_t{};
+        auto task = taskweaver::Task{};
+        EXPECT_THROW(task.emplace(capture), std::runtime_error);
+        EXPECT_FALSE(task.pending());
+
+        auto* next = taskweaver::SlabAllocator::ThreadAllocate(sizeof(throwing_t));
+        taskweaver::SlabAllocator::Deallocate(next);
+
+        return next == block;
+    });
+
+    EXPECT_TRUE(reused.get());
+}
+
+void memoryResourceTest()
+{
+    auto* resource = taskweaver::SlabAllocator::ThreadResource();
+
+    // the vector is filled from the slab of the executor thread and released by the test thread
+    auto future = taskweaver::TaskManager::SubmitTask([resource]() -> std::pmr::vector<uint64_t> {
+        auto& slab = taskweaver::Executor::ThreadExecutor().MemoryResource();
+        EXPECT_TRUE(slab.is_equal(*resource));
+        EXPECT_TRUE(resource->is_equal(slab));
+
+        auto v = std::pmr::vector<uint64_t>(&slab);
+        for (auto i = uint64_t{ 0 }; i < 32; i++) {
+            v.push_back(i);
+        }
+
+        return v;
+    });
+
+    {
+        auto v = future.get();
+        EXPECT_EQ(std::accumulate(v.begin(), v.end(), uint64_t{ 0 }), uint64_t{ 31 * 32 / 2 });
+    }
+
+    // over aligned and too large blocks go to the global heap
+    auto* aligned = resource->allocate(64, 64);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % 64, 0u);
+    resource->deallocate(aligned, 64, 64);
+
+    auto* large = resource->allocate(taskweaver::SlabAllocator::MaxBlockSize() + 1);
+    resource->deallocate(large, taskweaver::SlabAllocator::MaxBlockSize() + 1);
+}
+
+void executorMemoryResourceTest()
+{
+    // the resource of an executor hands out its slab blocks in the executor thread only
+    std::thread{ []() -> void {
+        auto taskManager = taskweaver::TaskManager{ taskweaver::task_manager_options_t{ .threadPoolSize = 1 } };
+        taskManager.Start();
+
+        auto* mainResource = &taskweaver::Executor::ThreadExecutor().MemoryResource();
+        auto done = std::latch{ 1 };
+
+        // the only worker runs the task, the main thread does not help
+        [[maybe_unused]] auto future = taskManager.Post([mainResource, &done]() -> void {
+            auto& own = taskweaver::Executor::ThreadExecutor().MemoryResource();
+
+            // the slab hands out the last released block first
+            auto reused = [](std::pmr::memory_resource& resource) -> bool {
+                auto* block = resource.allocate(48);
+                resource.deallocate(block, 48);
+
+                auto* next = taskweaver::SlabAllocator::ThreadAllocate(48);
+                taskweaver::SlabAllocator::Deallocate(next);
+
+                return next == block;
+            };
+
+            EXPECT_NE(&own, mainResource);
+            EXPECT_TRUE(reused(own));
+            EXPECT_FALSE(reused(*mainResource));
+
+            done.count_down();
+        });
+
+        done.wait();
+        taskManager.Stop();
+    } }.join();
+}
+
+void taskPriorityTest()
+{
+    auto& executor = taskweaver::Executor::ThreadExecutor();
+
+    // the other executors are kept busy, so the tasks below stay in the lanes of this one
+    auto workers = executor.TaskManager().ExecutorCount() - 1;
+    auto started = std::atomic<uint32_t>{ 0 };
+    auto release = std::atomic<bool>{ false };
+
+    for (auto i = uint32_t{ 0 }; i < workers; i++) {
+        executor.Dispatch([&started, &release]() -> void {
+            started.fetch_add(1);
+            while (!release.load())
+                std::this_thread::yield();
+            started.fetch_sub(1);
+        });
+    }
+
+    while (started.load() != workers)
+        std::this_thread::yield();
+
+    // higher lanes go first, but a low task gets its turn within 16 picks
+    constexpr auto count = size_t{ 8 };
+    auto order = std::vector<taskweaver::TaskPriority>{};
+
+    for (auto i = size_t{ 0 }; i < count; i++) {
+        executor.Dispatch(taskweaver::TaskPriority::Low,
+                          [&order]() -> void { order.push_back(taskweaver::TaskPriority::Low); });
+    }
+
+    for (auto i = size_t{ 0 }; i < count; i++) {
+        executor.Dispatch(taskweaver::TaskPriority::High,
+                          [&order]() -> void { order.push_back(taskweaver::TaskPriority::High); });
+    }
+
+    auto normal = taskweaver::TaskManager::SubmitTask(taskweaver::TaskPriority::Normal, []() -> int { return 1; });
+
+    while (executor.TryRunOne()) {
+    }
+
+    EXPECT_EQ(normal.get(), 1);
+    ASSERT_EQ(order.size(), 2 * count);
+    EXPECT_LE(std::count(order.begin(), order.begin() + count, taskweaver::TaskPriority::Low), 1);
+
+    // a high priority task which always resubmits itself does not starve the low lane
+    auto highRuns = size_t{ 0 };
+    auto lowRan = false;
+
+    auto flood = [&highRuns, &lowRan](auto& self) -> void {
+        highRuns++;
+        if (!lowRan && highRuns < 1000)
+            taskweaver::TaskManager::Dispatch(taskweaver::TaskPriority::High, [&self]() -> void { self(self); });
+    };
+
+    taskweaver::TaskManager::Dispatch(taskweaver::TaskPriority::Low, [&lowRan]() -> void { lowRan = true; });
+    taskweaver::TaskManager::Dispatch(taskweaver::TaskPriority::High, [&flood]() -> void { flood(flood); });
+
+    while (executor.TryRunOne()) {
+    }
+
+    EXPECT_TRUE(lowRan);
+    EXPECT_LE(highRuns, size_t{ 17 });
+
+    // the blockers refer to this frame
+    release.store(true);
+    while (started.load() != 0)
+        std::this_thread::yield();
+}
+
+void timersTest(taskweaver::TaskManager& taskManager)
+{
+    using namespace std::chrono_literals;
+
+    // delayed tasks never run early, whatever the order they were submitted in
+    constexpr auto count = size_t{ 1000 };
+    auto futures = std::vector<taskweaver::Future<bool>>{};
+    futures.reserve(count);
+
+    for (auto i = size_t{ 0 }; i < count; i++) {
+        auto delay = std::chrono::milliseconds{ 1 + (i * 7) % 30 };
+        auto deadline = std::chrono::steady_clock::now() + delay;
+
+        futures.push_back(taskManager.SubmitAfter(
+          delay, [deadline]() -> bool { return std::chrono::steady_clock::now() >= deadline; }));
+    }
+
+    for (auto& future : futures) {
+        EXPECT_TRUE(future.get());
+    }
+
+    // periodic task stops running once it is cancelled
+    auto runs = std::atomic<uint32_t>{ 0 };
+    auto handle = taskManager.SubmitEvery(2ms, [&runs]() -> void { runs.fetch_add(1); });
+
+    while (runs.load() < 5)
+        std::this_thread::sleep_for(1ms);
+
+    handle.cancel();
+
+    // a run may be in progress while the handle cancels the timer
+    std::this_thread::sleep_for(10ms);
+    auto stopped = runs.load();
+    std::this_thread::sleep_for(20ms);
+    EXPECT_EQ(runs.load(), stopped);
+
+    // a pending timer is cancelled at once, far ones too
+    auto far = taskManager.SubmitEvery(24h, []() -> void {});
+    EXPECT_TRUE(far.cancel());
+    EXPECT_FALSE(far.cancel());
+
+    // a timer submitted from a task
+    auto nested = taskManager.Post([&taskManager]() -> taskweaver::Future<int> {
+        return taskManager.SubmitAfter(5ms, []() -> int { return 42; });
+    });
+
+    EXPECT_EQ(nested.get().get(), 42);
+}
+
+void cancellationTest()
+{
+    // a task whose stop is requested before it starts is skipped
+    auto stop = std::stop_source{};
+    auto ran = std::atomic<bool>{ false };
+
+    stop.request_stop();
+    auto skipped = taskweaver::TaskManager::SubmitTask(stop.get_token(), [&ran]() -> int {
+        ran.store(true);
+        return 1;
+    });
+
+    EXPECT_THROW(skipped.get(), taskweaver::TaskCancelledError);
+    EXPECT_FALSE(ran.load());
+
+    // a running task polls the token
+    auto running = std::stop_source{};
+    auto started = std::atomic<bool>{ false };
+    auto polling = taskweaver::TaskManager::SubmitTask(running.get_token(), [&started](std::stop_token token) -> bool {
+        started.store(true);
+        while (!token.stop_requested())
+            std::this_thread::yield();
+        return true;
+    });
+
+    while (!started.load())
+        std::this_thread::yield();
+
+    running.request_stop();
+    EXPECT_TRUE(polling.get());
+
+    // the winner of when_any stops the speculative losers, the counters outlive the skipped tasks
+    constexpr auto losers = size_t{ 64 };
+    auto search = std::stop_source{};
+    auto counters = std::make_shared<std::array<std::atomic<size_t>, 2>>();
+    auto winner = taskweaver::Promise<size_t>{};
+    auto futures = std::vector<taskweaver::Future<size_t>>{};
+
+    futures.push_back(winner.get_future());
+
+    for (auto i = size_t{ 1 }; i <= losers; i++) {
+        futures.push_back(
+          taskweaver::TaskManager::SubmitTask(search.get_token(), [counters, i](std::stop_token token) -> size_t {
+              (*counters)[0].fetch_add(1);
+              while (!token.stop_requested())
+                  std::this_thread::yield();
+              (*counters)[1].fetch_add(1);
+              return i;
+          }));
+    }
+
+    auto any = taskweaver::when_any(search, futures);
+
+    while ((*counters)[0].load() == 0)
+        std::this_thread::yield();
+
+    winner.set_value(0);
+
+    EXPECT_EQ(any.get().index, size_t{ 0 });
+    EXPECT_TRUE(search.stop_requested());
+
+    while ((*counters)[1].load() != (*counters)[0].load())
+        std::this_thread::yield();
+
+    EXPECT_LT((*counters)[0].load(), losers);
+}
+
+void mainThreadWorkerTest(taskweaver::TaskManager& taskManager)
+{
+    using namespace std::chrono_literals;
+
+    // no thread more than hardware threads
+    EXPECT_EQ(taskManager.ExecutorCount(), std::max(std::thread::hardware_concurrency(), 1u));
+
+    // the main thread takes its own tasks, the workers steal the rest
+    constexpr auto count = uint32_t{ 1000 };
+    auto done = std::atomic<uint32_t>{ 0 };
+
+    for (auto i = uint32_t{ 0 }; i < count; i++) {
+        taskweaver::TaskManager::Dispatch([&done]() -> void { done.fetch_add(1); });
+    }
+
+    taskManager.RunUntil([&done]() -> bool { return done.load() == count; });
+    EXPECT_EQ(done.load(), count);
+
+    // nothing to run
+    while (taskManager.RunOne()) {
+    }
+    EXPECT_FALSE(taskManager.RunOne());
+
+    // the main thread fires timers too, the run lasts the whole duration
+    auto fired = std::atomic<bool>{ false };
+    auto timer = taskManager.SubmitAfter(5ms, [&fired]() -> void { fired.store(true); });
+
+    auto start = std::chrono::steady_clock::now();
+    taskManager.RunFor(20ms);
+
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 20ms);
+    EXPECT_TRUE(fired.load());
+    timer.get();
+
+    // futures are awaited as before
+    auto future = taskweaver::TaskManager::SubmitTask([]() -> uint64_t { return recursive_sum(0, 1024); });
+    EXPECT_EQ(future.get(), uint64_t{ 1024 * 1023 / 2 });
+}
+
+void statisticsTest(taskweaver::TaskManager& taskManager)
+{
+    constexpr auto count = uint64_t{ 1 } << 12;
+
+    auto before = taskManager.Stats();
+    auto sum = taskweaver::TaskManager::SubmitTask([]() -> uint64_t { return recursive_sum(0, count); }).get();
+    auto after = taskManager.Stats();
+
+    EXPECT_EQ(sum, count * (count - 1) / 2);
+
+#if defined(TASKWEAVER_STATISTICS)
+    EXPECT_GE(after.steals.attempts, before.steals.attempts);
+
+    // a task per split of 16 numbers, the last one may still be finishing its run
+    EXPECT_GE(after.executedTasks - before.executedTasks, count / 16 - 1);
+
+    // every task is taken from an own lane, stolen or injected
+    EXPECT_LE(after.executedTasks, after.localPops + after.steals.steals + after.injectedTasks);
+    EXPECT_GE(after.maxQueueDepth, uint64_t{ 1 });
+#else
+    EXPECT_EQ(after.executedTasks, uint64_t{ 0 });
+    EXPECT_EQ(after.maxQueueDepth, uint64_t{ 0 });
+    EXPECT_EQ(before.steals.attempts, uint64_t{ 0 });
+    EXPECT_EQ(after.steals.attempts, uint64_t{ 0 });
+    EXPECT_EQ(after.steals.steals, uint64_t{ 0 });
+#endif
+}
+
+void tracingTest(taskweaver::TaskManager& taskManager)
+{
+    taskManager.StartTracing();
+
+    auto future = taskweaver::TaskManager::SubmitTask([]() -> uint64_t {
+        taskweaver::TaskManager::TagTask("sum \"root\"");
+        return recursive_sum(0, 1024);
+    });
+
+    EXPECT_EQ(future.get(), uint64_t{ 1024 * 1023 / 2 });
+
+    taskManager.StopTracing();
+
+    auto out = std::ostringstream{};
+    taskManager.WriteTrace(out);
+    auto trace = out.str();
+
+    // executors are named threads whether the events are compiled in or not
+    EXPECT_EQ(trace.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0), 0u);
+    EXPECT_NE(trace.find("\"name\":\"executor 0\""), std::string::npos);
+    EXPECT_EQ(trace.substr(trace.size() - 4), "\n]}\n");
+
+#if defined(TASKWEAVER_TRACING)
+    // the tag is escaped, the splits are anonymous tasks
+    EXPECT_NE(trace.find("{\"name\":\"sum \\\"root\\\"\",\"cat\":\"task\""), std::string::npos);
+    EXPECT_NE(trace.find("{\"name\":\"task\",\"cat\":\"task\""), std::string::npos);
+    EXPECT_NE(trace.find("\"ph\":\"X\",\"dur\":"), std::string::npos);
+#else
+    EXPECT_EQ(trace.find("\"ph\":\"X\""), std::string::npos);
+#endif
+}
+
+void nestedWaitTest()
+{
+    constexpr auto count = uint64_t{ 1 } << 12;
+
+    auto future = taskweaver::TaskManager::SubmitTask([]() -> uint64_t { return recursive_sum(0, count); });
+
+    EXPECT_EQ(future.get(), count * (count - 1) / 2);
+}
+
+void sharedWaitTest()
+{
+    // two workers wait the same future, the completion wakes up both of them
+    std::thread{ []() -> void {
+        auto taskManager = taskweaver::TaskManager{ taskweaver::task_manager_options_t{ .threadPoolSize = 2 } };
+        taskManager.Start();
+
+        auto promise = taskweaver::Promise<void>{};
+        auto const future = promise.get_future();
+        auto arrived = std::latch{ 2 };
+        auto done = std::atomic<uint32_t>{ 0 };
+
+        auto waiter = [&future, &arrived, &done]() -> void {
+            // blocks the thread, so the other waiter goes to the other worker
+            arrived.arrive_and_wait();
+
+            future.wait();
+            done++;
+        };
+
+        auto first = taskManager.Post(waiter);
+        auto second = taskManager.Post(waiter);
+
+        // both workers are parked by now
+        std::this_thread::sleep_for(std::chrono::milliseconds{ 50 });
+        promise.set_value();
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{ 5 };
+        while (done.load() != 2 && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+
+        EXPECT_EQ(done.load(), 2u);
+
+        // wakes up a forgotten waiter, so the test fails rather than hangs
+        taskManager.Stop();
+    } }.join();
+}
+
+void timedWaitTest(taskweaver::TaskManager& taskManager)
+{
+    using namespace std::chrono_literals;
+
+    // a thread without executor sleeps through the timeout rather than spinning
+    std::thread{ [&taskManager]() -> void {
+        ASSERT_FALSE(taskweaver::Executor::HasThreadExecutor());
+
+        auto promise = taskweaver::Promise<uint32_t>{};
+        auto future = promise.get_future();
+
+#if defined(__linux__)
+        auto cpuTime = []() -> std::chrono::nanoseconds {
+            auto time = timespec{};
+            ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+            return std::chrono::seconds{ time.tv_sec } + std::chrono::nanoseconds{ time.tv_nsec };
+        };
+        auto cpuBegin = cpuTime();
+#endif
+        auto begin = std::chrono::steady_clock::now();
+
+        EXPECT_EQ(future.wait_for(50ms), std::future_status::timeout);
+        EXPECT_GE(std::chrono::steady_clock::now() - begin, 50ms);
+#if defined(__linux__)
+        EXPECT_LT(cpuTime() - cpuBegin, 25ms);
+#endif
+        EXPECT_EQ(future.wait_until(std::chrono::system_clock::now() + 1ms), std::future_status::timeout);
+
+        // the completion wakes up the sleeping thread
+        [[maybe_unused]] auto posted = taskManager.Post([&promise]() -> void {
+            std::this_thread::sleep_for(10ms);
+            promise.set_value(7);
+        });
+
+        EXPECT_EQ(future.wait_for(10s), std::future_status::ready);
+        EXPECT_EQ(future.get(), 7u);
+    } }.join();
+
+    // an executor thread times out too, and runs other tasks while it waits
+    auto inner = taskweaver::TaskManager::SubmitTask([]() -> bool {
+        auto never = taskweaver::Promise<void>{};
+        auto timedOut = never.get_future().wait_for(10ms) == std::future_status::timeout;
+
+        auto nested = taskweaver::TaskManager::SubmitTask([]() -> uint32_t { return 42; });
+        return timedOut && nested.wait_for(10s) == std::future_status::ready && nested.get() == 42;
+    });
+
+    EXPECT_TRUE(inner.get());
+}
+
 TEST_F(TaskManagerTest, ParrallelComputationWhenAll)
 {
     parrallelComputationWhenAllTest();
@@ -107,3 +1094,128 @@ TEST_F(TaskManagerTest, WhenAny)
 {
     whenAnyTest();
 }
+
+TEST_F(TaskManagerTest, WakeUpAfterIdle)
+{
+    wakeUpAfterIdleTest();
+}
+
+TEST_F(TaskManagerTest, PostFromExternalThread)
+{
+    postFromExternalThreadTest(TaskManager());
+}
+
+TEST_F(TaskManagerTest, PostToFullQueue)
+{
+    postToFullQueueTest();
+}
+
+TEST_F(TaskManagerTest, FutureException)
+{
+    futureExceptionTest();
+}
+
+TEST_F(TaskManagerTest, Dispatch)
+{
+    dispatchTest();
+}
+
+TEST_F(TaskManagerTest, NestedWait)
+{
+    nestedWaitTest();
+}
+
+TEST_F(TaskManagerTest, SharedWait)
+{
+    sharedWaitTest();
+}
+
+TEST_F(TaskManagerTest, TimedWait)
+{
+    timedWaitTest(TaskManager());
+}
+
+TEST_F(TaskManagerTest, Combinators)
+{
+    combinatorsTest();
+}
+
+TEST_F(TaskManagerTest, Then)
+{
+    thenTest();
+}
+
+TEST_F(TaskManagerTest, ThenAfterStop)
+{
+    thenAfterStopTest();
+}
+
+TEST_F(TaskManagerTest, TaskGraph)
+{
+    taskGraphTest();
+}
+
+TEST_F(TaskManagerTest, TaskGraphLifetime)
+{
+    taskGraphLifetimeTest();
+}
+
+TEST_F(TaskManagerTest, ParallelFor)
+{
+    parallelForTest();
+}
+
+TEST_F(TaskManagerTest, ParallelAlgorithms)
+{
+    parallelAlgorithmsTest();
+}
+
+TEST_F(TaskManagerTest, AsyncTask)
+{
+    asyncTaskTest();
+}
+
+TEST_F(TaskManagerTest, TaskStorage)
+{
+    taskStorageTest();
+}
+
+TEST_F(TaskManagerTest, MemoryResource)
+{
+    memoryResourceTest();
+}
+
+TEST_F(TaskManagerTest, ExecutorMemoryResource)
+{
+    executorMemoryResourceTest();
+}
+
+TEST_F(TaskManagerTest, TaskPriority)
+{
+    taskPriorityTest();
+}
+
+TEST_F(TaskManagerTest, Cancellation)
+{
+    cancellationTest();
+}
+
+TEST_F(TaskManagerTest, Statistics)
+{
+    statisticsTest(TaskManager());
+}
+
+TEST_F(TaskManagerTest, Tracing)
+{
+    tracingTest(TaskManager());
+}
+
+TEST_F(TaskManagerTest, Timers)
+{
+    timersTest(TaskManager());
+}
+
+TEST_F(MainThreadWorkerTest, Run)
+{
+    mainThreadWorkerTest(TaskManager());
+}
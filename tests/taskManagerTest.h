@@ -16,7 +16,7 @@ public:
 protected:
     void SetUp() override
     {
-        taskManager_ = std::make_unique<taskweaver::TaskManager>();
+        taskManager_ = std::make_unique<taskweaver::TaskManager>(Options());
         taskManager_->Start();
     }
 
@@ -26,8 +26,22 @@ protected:
         taskManager_.reset();
     }
 
+    auto TaskManager() -> taskweaver::TaskManager& { return *taskManager_; }
+
+    [[nodiscard]] virtual auto Options() const -> taskweaver::task_manager_options_t { return {}; }
+
 private:
     std::unique_ptr<taskweaver::TaskManager> taskManager_;
 };
 
+// the main thread is one of the workers, it runs its executor by TaskManager::Run* calls
+class MainThreadWorkerTest : public TaskManagerTest
+{
+protected:
+    [[nodiscard]] auto Options() const -> taskweaver::task_manager_options_t override
+    {
+        return taskweaver::task_manager_options_t{ .mainThreadWorker = true };
+    }
+};
+
 #endif // TASKWEAVER_TASKMANAGERTEST_H
@@ -162,3 +162,85 @@ TEST_F(TaskStealingDequeTest, EdgeCases)
     // Test stealing from an empty deque
     EXPECT_EQ(deque->TrySteal(), std::nullopt);
 }
+
+TEST_F(TaskStealingDequeTest, ConcurrentTryPopAndTryStealBatch)
+{
+    constexpr auto taskCount = int32_t{ 100000 };
+    constexpr auto thiefCount = size_t{ 3 };
+
+    auto consumed = std::make_unique<std::atomic<uint32_t>[]>(taskCount);
+    auto done = std::atomic<bool>{ false };
+
+    auto consume = [&consumed](int32_t item) -> void { consumed[item].fetch_add(1, std::memory_order_relaxed); };
+
+    auto thieves = std::vector<std::thread>{};
+    for (auto i = size_t{ 0 }; i < thiefCount; ++i) {
+        thieves.emplace_back([this, &done, &consume]() {
+            auto own = taskweaver::TaskStealingDeque<int32_t>{ 64 };
+
+            while (!done.load(std::memory_order_acquire) || !deque->IsEmpty()) {
+                if (auto task = deque->TryStealBatch(own)) {
+                    consume(task.value());
+                }
+
+                while (auto task = own.TryPop()) {
+                    consume(task.value());
+                }
+            }
+        });
+    }
+
+    // producer interleaves pushes and pops, so pops race with batch steals
+    for (auto i = int32_t{ 0 }; i < taskCount; ++i) {
+        while (!deque->TryEmplace(i)) {
+            std::this_thread::yield();
+        }
+
+        if (i % 3 == 0) {
+            if (auto task = deque->TryPop()) {
+                consume(task.value());
+            }
+        }
+    }
+
+    while (auto task = deque->TryPop()) {
+        consume(task.value());
+    }
+
+    done.store(true, std::memory_order_release);
+
+    for (auto&& thief : thieves) {
+        thief.join();
+    }
+
+    for (auto i = int32_t{ 0 }; i < taskCount; ++i) {
+        ASSERT_EQ(consumed[i].load(), 1u) << "item " << i;
+    }
+}
+
+TEST_F(TaskStealingDequeTest, EmplaceGrowsFullDeque)
+{
+    auto capacity = deque->Capacity();
+
+    for (auto i = size_t{ 0 }; i < capacity; ++i) {
+        EXPECT_TRUE(deque->TryEmplace(i));
+    }
+    EXPECT_FALSE(deque->TryEmplace(42));
+
+    // steals some, so the ring is wrapped around when it grows
+    for (auto i = int32_t{ 0 }; i < 10; ++i) {
+        EXPECT_EQ(deque->TrySteal(), i);
+    }
+
+    for (auto i = capacity; i < capacity * 3; ++i) {
+        deque->Emplace(static_cast<int32_t>(i));
+    }
+    EXPECT_EQ(deque->Capacity(), capacity * 4);
+
+    for (auto i = static_cast<int32_t>(capacity * 3) - 1; i >= 10; --i) {
+        auto task = deque->TryPop();
+        EXPECT_TRUE(task.has_value());
+        EXPECT_EQ(task.value(), i);
+    }
+    EXPECT_TRUE(deque->IsEmpty());
+}
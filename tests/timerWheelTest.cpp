@@ -0,0 +1,111 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#include "timerWheelTest.h"
+
+TEST_F(TimerWheelTest, EmptyWheel)
+{
+    EXPECT_EQ(wheel->Size(), 0u);
+    EXPECT_EQ(wheel->NextDeadline(), clock_t::time_point::max());
+    EXPECT_EQ(Expire(base + std::chrono::hours{ 1 }), 0u);
+}
+
+TEST_F(TimerWheelTest, FiresOnDeadlineOnAllLevels)
+{
+    using namespace std::chrono_literals;
+
+    // level and block boundaries, the last two are beyond the wheel and wait in the overflow list
+    auto const delays = std::vector<std::chrono::milliseconds>{
+        1ms, 63ms, 64ms, 65ms, 4095ms, 4096ms, 4097ms, 262'143ms, 262'144ms, 300'000ms, 5h, 10h
+    };
+
+    for (auto id = size_t{ 0 }; id < delays.size(); id++) {
+        wheel->Insert(MakeTimer(id), base + delays[id]);
+    }
+
+    EXPECT_EQ(wheel->Size(), delays.size());
+
+    for (auto id = size_t{ 0 }; id < delays.size(); id++) {
+        auto deadline = base + delays[id];
+
+        // the next deadline is a lower bound
+        EXPECT_LE(wheel->NextDeadline(), deadline + taskweaver::TimerWheel::tick_v);
+
+        // never early
+        EXPECT_EQ(Expire(deadline - 1us), 0u) << "timer " << id;
+        EXPECT_EQ(Expire(deadline + taskweaver::TimerWheel::tick_v), 1u) << "timer " << id;
+        ASSERT_EQ(fired.size(), id + 1);
+        EXPECT_EQ(fired.back(), id);
+    }
+
+    EXPECT_EQ(wheel->Size(), 0u);
+    EXPECT_EQ(wheel->NextDeadline(), clock_t::time_point::max());
+}
+
+TEST_F(TimerWheelTest, Cancel)
+{
+    using namespace std::chrono_literals;
+
+    constexpr auto count = size_t{ 100'000 };
+
+    // the handles keep the timers alive after the wheel releases them
+    auto handles = std::vector<taskweaver::TimerHandle>{};
+    handles.reserve(count);
+
+    for (auto id = size_t{ 0 }; id < count; id++) {
+        auto* timer = MakeTimer(id);
+        timer->add_ref();
+        handles.emplace_back(timer);
+
+        wheel->Insert(timer, base + std::chrono::milliseconds{ 1 + id % 5000 });
+    }
+
+    for (auto id = size_t{ 0 }; id < count; id += 2) {
+        EXPECT_TRUE(handles[id].cancel());
+        EXPECT_FALSE(handles[id].cancel());
+    }
+
+    EXPECT_EQ(wheel->Size(), count / 2);
+    EXPECT_EQ(Expire(base + 10s), count / 2);
+
+    for (auto id : fired) {
+        EXPECT_EQ(id % 2, 1u);
+    }
+
+    // fired timers can not be cancelled
+    EXPECT_FALSE(handles[1].cancel());
+}
+
+TEST_F(TimerWheelTest, InsertIntoPast)
+{
+    using namespace std::chrono_literals;
+
+    EXPECT_EQ(Expire(base + 1s), 0u);
+
+    // the wheel has already passed the deadline, so the timer is due at once
+    wheel->Insert(MakeTimer(0), base + 10ms);
+
+    EXPECT_LE(wheel->NextDeadline(), base + 1s);
+    EXPECT_EQ(Expire(base + 1s), 1u);
+}
+
+TEST_F(TimerWheelTest, Clear)
+{
+    using namespace std::chrono_literals;
+
+    auto* timer = MakeTimer(0, 1);
+    timer->add_ref();
+    auto handle = taskweaver::TimerHandle{ timer };
+
+    wheel->Insert(timer, base + 1s);
+    wheel->Insert(MakeTimer(1), base + 10h);
+    wheel->Clear();
+
+    EXPECT_EQ(wheel->Size(), 0u);
+    EXPECT_EQ(Expire(base + 20h), 0u);
+    EXPECT_TRUE(fired.empty());
+
+    // cleared timers count as cancelled
+    EXPECT_FALSE(handle.cancel());
+}
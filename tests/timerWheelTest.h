@@ -0,0 +1,50 @@
+//
+// Created by anton on 10/17/26.
+//
+
+#ifndef TASKWEAVER_TIMERWHEELTEST_H
+#define TASKWEAVER_TIMERWHEELTEST_H
+
+#include "../src/timerWheel.h"
+#include <gtest/gtest.h>
+
+class TimerWheelTest : public ::testing::Test
+{
+protected:
+    using clock_t = taskweaver::TimerWheel::clock_t;
+
+    void SetUp() override
+    {
+        base = clock_t::now();
+        wheel = std::make_unique<taskweaver::TimerWheel>();
+    }
+
+    void TearDown() override { wheel.reset(); }
+
+    // the timer adds its id to fired when it runs
+    auto MakeTimer(size_t id, uint64_t period = 0) -> taskweaver::internal::timer_node_t*
+    {
+        return new taskweaver::internal::timer_node_t{ *wheel, period, [this, id]() -> void { fired.push_back(id); } };
+    }
+
+    // runs and releases the expired timers, returns how many there were
+    auto Expire(clock_t::time_point now) -> size_t
+    {
+        auto count = size_t{ 0 };
+
+        for (auto* timer = wheel->Expire(now); timer != nullptr; count++) {
+            auto* next = timer->next;
+            timer->task();
+            timer->release();
+            timer = next;
+        }
+
+        return count;
+    }
+
+    clock_t::time_point base;
+    std::unique_ptr<taskweaver::TimerWheel> wheel;
+    std::vector<size_t> fired;
+};
+
+#endif // TASKWEAVER_TIMERWHEELTEST_H
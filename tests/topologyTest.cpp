@@ -0,0 +1,125 @@
+//
+// Created by anton on 10/18/26.
+//
+
+#include "topologyTest.h"
+#include "../src/taskManager.h"
+
+TEST_F(TopologyTest, ParseCpuList)
+{
+    EXPECT_EQ(taskweaver::Topology::ParseCpuList("0-3,8,10-11"), (std::vector<uint32_t>{ 0, 1, 2, 3, 8, 10, 11 }));
+    EXPECT_EQ(taskweaver::Topology::ParseCpuList("5"), (std::vector<uint32_t>{ 5 }));
+    EXPECT_TRUE(taskweaver::Topology::ParseCpuList("").empty());
+}
+
+TEST_F(TopologyTest, PlacementOrder)
+{
+    auto topology = taskweaver::Topology{ DualSocket() };
+
+    // the physical cores of the first package, then of the second one, then the siblings in the same order
+    auto order = std::vector<uint32_t>{};
+    for (auto const& cpu : topology.Cpus()) {
+        order.push_back(cpu.cpu);
+    }
+
+    EXPECT_EQ(order, (std::vector<uint32_t>{ 0, 1, 2, 3, 4, 5, 6, 7 }));
+
+    // consecutive executors share the package, more executors than cpus wrap around
+    EXPECT_EQ(topology.Placement(0).package, topology.Placement(1).package);
+    EXPECT_NE(topology.Placement(1).package, topology.Placement(2).package);
+    EXPECT_EQ(topology.Placement(8).cpu, topology.Placement(0).cpu);
+}
+
+TEST_F(TopologyTest, Detect)
+{
+    auto allowed = taskweaver::Topology::ThreadAffinity();
+    auto topology = taskweaver::Topology::Detect();
+
+    ASSERT_EQ(topology.CpuCount(), allowed.size());
+
+    for (auto const& cpu : topology.Cpus()) {
+        EXPECT_NE(std::find(allowed.begin(), allowed.end(), cpu.cpu), allowed.end());
+        EXPECT_LE(cpu.l2, cpu.cpu);
+    }
+
+    // restricted by a cpuset, the one without allowed cpus is ignored
+    auto restricted = taskweaver::Topology::Detect({ allowed.back() });
+    ASSERT_EQ(restricted.CpuCount(), 1u);
+    EXPECT_EQ(restricted.Cpus().front().cpu, allowed.back());
+
+    EXPECT_EQ(taskweaver::Topology::Detect({ 1u << 20 }).CpuCount(), allowed.size());
+}
+
+TEST_F(TopologyTest, PinnedExecutors)
+{
+    auto topology = taskweaver::Topology::Detect();
+    auto mainAffinity = taskweaver::Topology::ThreadAffinity();
+
+    auto options = taskweaver::task_manager_options_t{ .mainThreadWorker = true, .pinThreads = true };
+    auto taskManager = taskweaver::TaskManager{ options };
+    taskManager.Start();
+
+    // every executor thread runs on the cpu of its placement
+    auto affinities = std::vector<taskweaver::Future<std::vector<uint32_t>>>{};
+    for (auto i = size_t{ 0 }; i < taskManager.ExecutorCount(); i++) {
+        affinities.push_back(taskManager.Post([]() -> std::vector<uint32_t> {
+            auto affinity = taskweaver::Topology::ThreadAffinity();
+            EXPECT_EQ(affinity, (std::vector<uint32_t>{ taskweaver::Executor::ThreadExecutor().Placement().cpu }));
+            return affinity;
+        }));
+    }
+
+    for (auto& affinity : affinities) {
+        EXPECT_EQ(affinity.get().size(), 1u);
+    }
+
+    EXPECT_EQ(taskweaver::Topology::ThreadAffinity(), (std::vector<uint32_t>{ topology.Placement(0).cpu }));
+
+    // the main thread gets its affinity back
+    taskManager.Stop();
+    EXPECT_EQ(taskweaver::Topology::ThreadAffinity(), mainAffinity);
+}
+
+TEST_F(TopologyTest, StealDistances)
+{
+#if !defined(TASKWEAVER_STATISTICS)
+    GTEST_SKIP() << "steals are counted with TASKWEAVER_STATISTICS only";
+#endif
+
+    auto topology = taskweaver::Topology::Detect();
+    auto options = taskweaver::task_manager_options_t{ .threadPoolSize = 4, .remoteStealBackoff = 0 };
+    auto taskManager = taskweaver::TaskManager{ options };
+    taskManager.Start();
+
+    // executors are robbed as long as there are parallel branches
+    auto sum = std::atomic<uint64_t>{ 0 };
+    auto futures = std::vector<taskweaver::Future<void>>{};
+
+    for (auto i = uint64_t{ 0 }; i < 4096; i++) {
+        futures.push_back(taskweaver::TaskManager::SubmitTask([&sum, i]() -> void {
+            for (auto j = 0; j < 100; j++) {
+                sum.fetch_add(i, std::memory_order_relaxed);
+            }
+        }));
+    }
+
+    for (auto& future : futures) {
+        future.get();
+    }
+
+    taskManager.Stop();
+
+    auto stats = taskManager.Stats().steals;
+    EXPECT_EQ(sum.load(), uint64_t{ 100 } * 4096 * 4095 / 2);
+    EXPECT_LE(stats.localSteals + stats.remoteSteals, stats.steals);
+
+    // all the victims share the node, so no steal crosses it
+    auto nodes = std::vector<uint32_t>{};
+    for (auto const& cpu : topology.Cpus()) {
+        nodes.push_back(cpu.node);
+    }
+
+    if (std::adjacent_find(nodes.begin(), nodes.end(), std::not_equal_to<>{}) == nodes.end()) {
+        EXPECT_EQ(stats.remoteSteals, 0u);
+    }
+}
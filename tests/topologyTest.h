@@ -0,0 +1,35 @@
+//
+// Created by anton on 10/18/26.
+//
+
+#ifndef TASKWEAVER_TOPOLOGYTEST_H
+#define TASKWEAVER_TOPOLOGYTEST_H
+
+#include "../src/topology.h"
+#include <gtest/gtest.h>
+
+class TopologyTest : public ::testing::Test
+{
+protected:
+    // two packages of two cores with two hyper-threads each, numbered like linux does:
+    // the first threads of all the cores go first, the siblings follow
+    static auto DualSocket() -> std::vector<taskweaver::cpu_info_t>
+    {
+        auto cpus = std::vector<taskweaver::cpu_info_t>{};
+
+        for (auto cpu = uint32_t{ 0 }; cpu < 8; cpu++) {
+            auto core = cpu % 4;
+            auto package = core / 2;
+            auto first = core; // the lowest cpu of the core
+
+            cpus.push_back(taskweaver::cpu_info_t{ cpu, core, first, package * 2, package, package });
+        }
+
+        // listed in reverse, the order must not depend on the input
+        std::reverse(cpus.begin(), cpus.end());
+
+        return cpus;
+    }
+};
+
+#endif // TASKWEAVER_TOPOLOGYTEST_H